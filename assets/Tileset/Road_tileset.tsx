@@ -4,46 +4,64 @@
  <tile id="0">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="1">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="2">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="3">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="4">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="5">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="6">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="7">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="8">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="9">
@@ -59,11 +77,15 @@
  <tile id="11">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="12">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="13">
@@ -79,11 +101,15 @@
  <tile id="15">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="16">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="17">
@@ -119,6 +145,8 @@
  <tile id="23">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="24">
@@ -144,6 +172,8 @@
  <tile id="28">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="29">
@@ -159,11 +189,15 @@
  <tile id="31">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="32">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="33">
@@ -199,6 +233,8 @@
  <tile id="39">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="40">
@@ -224,6 +260,8 @@
  <tile id="44">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="45">
@@ -239,11 +277,15 @@
  <tile id="47">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="48">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="49">
@@ -269,11 +311,15 @@
  <tile id="55">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="56">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="57">
@@ -289,11 +335,15 @@
  <tile id="59">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="60">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="61">
@@ -309,11 +359,15 @@
  <tile id="63">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="64">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="65">
@@ -339,51 +393,71 @@
  <tile id="71">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="72">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="73">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="74">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="75">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="76">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="77">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="78">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="79">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="80">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="81">
@@ -419,26 +493,36 @@
  <tile id="87">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="88">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="89">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="90">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="91">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="92">
@@ -464,6 +548,8 @@
  <tile id="96">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="97">
@@ -499,26 +585,36 @@
  <tile id="103">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="104">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="105">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="106">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="107">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="108">
@@ -544,86 +640,120 @@
  <tile id="112">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="113">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="114">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="115">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="116">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="117">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="118">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="119">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="120">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="121">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="122">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="123">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="124">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="125">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="126">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="127">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="128">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="129">
@@ -639,11 +769,15 @@
  <tile id="131">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="132">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="133">
@@ -659,6 +793,8 @@
  <tile id="135">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="144">
@@ -679,6 +815,8 @@
  <tile id="147">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="148">
@@ -719,6 +857,8 @@
  <tile id="163">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="164">
@@ -744,6 +884,8 @@
  <tile id="176">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="177">
@@ -759,31 +901,43 @@
  <tile id="179">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="180">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="181">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="182">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="183">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="192">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="193">
@@ -799,31 +953,43 @@
  <tile id="195">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="196">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="197">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="198">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="199">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="208">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="209">
@@ -864,6 +1030,8 @@
  <tile id="224">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="225">
@@ -904,6 +1072,8 @@
  <tile id="240">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="241">
@@ -919,11 +1089,15 @@
  <tile id="243">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="244">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
  <tile id="245">
@@ -939,6 +1113,8 @@
  <tile id="247">
   <properties>
    <property name="type" type="int" value="1"/>
+   <property name="friction" type="float" value="1.5"/>
+   <property name="speed" type="float" value="0.7"/>
   </properties>
  </tile>
 </tileset>
@@ -0,0 +1,178 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#pragma once
+#include <hungerland/map.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace hungerland {
+namespace map {
+
+	///
+	/// \brief The hungerland::map::ChunkStreamer class
+	///
+	/// Drawable chunks of tile layers, streamed around the view. Each chunk is CHUNK_SIZE x CHUNK_SIZE
+	/// tiles with its own quad mesh and lookup texture for each used tileset, so GPU memory and startup
+	/// time depend on the view size, not on the map size. Lookup textures are GL_R16UI, 2 bytes per
+	/// tile: tileset relative tile id in low 13 bits and flips in high 3 bits as in TileData.
+	/// Lookup pixels of chunks near the view are built by a background thread, uploaded by update in
+	/// the GL thread and evicted, when the chunk gets far from the view. Visible chunks which are not
+	/// built yet are built right away, so holes are never drawn.
+	/// Tiles edited with setTile mark a dirty rectangle of their chunk. Next update writes only the
+	/// dirty rectangles of loaded chunks to their lookup textures. Scrolled layers are streamed again.
+	///
+	/// @ingroup hungerland::map
+	///
+	class ChunkStreamer {
+	public:
+		static constexpr int	CHUNK_SIZE = 32;		// Chunk width and height in tiles
+		static constexpr int	PREFETCH_CHUNKS = 1;	// Chunks around the view which are built in background
+		static constexpr int	KEEP_CHUNKS = 2;		// Chunks further than this from the view are evicted
+		static constexpr size_t	MAX_UPLOADS = 4;		// Maximum number of prefetched chunks uploaded in one update
+
+		///
+		/// \brief ChunkStreamer Starts the background thread.
+		/// \param layers			= Tile layers of the map.
+		/// \param tilesets			= Tilesets of the map.
+		/// \param tilesetTextures	= Texture of each tileset.
+		/// \param tileSize			= Size of tile in pixels.
+		///
+		ChunkStreamer(const std::vector< std::shared_ptr<TileLayer> >& layers, const std::vector<TilesetInfo>& tilesets,
+			const std::vector< std::shared_ptr<texture::Texture> >& tilesetTextures, const size2d_t& tileSize);
+
+		~ChunkStreamer();
+
+		///
+		/// \brief update Loads chunks in and near the view, and evicts chunks far from it. Must be called from the GL thread.
+		/// \param view	= Left, top, right and bottom of the visible area in map pixels.
+		///
+		void update(const glm::vec4& view);
+
+		///
+		/// \brief setTile Changes tile of the layer and marks it dirty. Must be called from the thread calling update.
+		/// \param layerIndex	= Index of the tile layer, as in Map::getTileLayers.
+		/// \param x, y		= Tile coordinates.
+		/// \param id			= Global tile id, 0 for empty tile.
+		/// \param flipFlags	= Flips of the tile as in TileData::getFlags.
+		///
+		void setTile(size_t layerIndex, size_t x, size_t y, int id, int flipFlags);
+
+		///
+		/// \brief scroll Moves tiles of all layers columns to the left, see TileData::scroll. All chunks are
+		/// evicted, and chunks built before the scroll are discarded. Must be called from the thread calling update.
+		/// \param columns	= Number of columns to scroll.
+		///
+		void scroll(size_t columns);
+
+		///
+		/// \brief forEachVisible Calls f(const TileSetSubset&) for each used subset of loaded chunks of the layer in the view.
+		/// \param layerIndex	= Index of the tile layer, as in Map::getTileLayers.
+		/// \param view			= Left, top, right and bottom of the visible area in map pixels.
+		///
+		template<typename Func>
+		void forEachVisible(size_t layerIndex, const glm::vec4& view, Func f) const {
+			const auto range = getRange(layerIndex, view, 0);
+			for(int cy = range.y; cy <= range.w; ++cy) {
+				for(int cx = range.x; cx <= range.z; ++cx) {
+					auto it = m_loaded.find(getKey(layerIndex, cx, cy));
+					if(it == m_loaded.end()) {
+						continue;
+					}
+					for(const auto& subset : it->second.subsets) {
+						f(subset);
+					}
+				}
+			}
+		}
+
+		///
+		/// \brief getNumLoaded
+		/// \return Number of chunks uploaded to GL.
+		///
+		size_t getNumLoaded() const {
+			return m_loaded.size();
+		}
+
+		ChunkStreamer(const ChunkStreamer&) = delete;
+		ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+	private:
+		static constexpr uint64_t NOT_BUILDING = ~uint64_t(0);
+
+		struct Chunk {
+			std::vector<size_t>			tilesetIds;	// Used tilesets
+			std::vector<TileSetSubset>	subsets;	// Subset of each used tileset
+		};
+
+		struct BuiltChunk {
+			uint64_t						key = 0;
+			uint64_t						revision = 0;	// Number of edits when tiles were read
+			std::vector<size_t>				tilesetIds;	// Used tilesets
+			std::vector< std::vector<uint16_t> >	pixels;		// Lookup pixels of each used tileset
+		};
+
+		static uint64_t getKey(size_t layerIndex, int cx, int cy) {
+			return (uint64_t(layerIndex) << 48) | (uint64_t(cy) << 24) | uint64_t(cx);
+		}
+
+		static glm::ivec3 getChunk(uint64_t key) {
+			return glm::ivec3(int(key & 0xffffff), int((key >> 24) & 0xffffff), int(key >> 48));
+		}
+
+		// Chunks of the layer overlapping the view expanded by margin chunks: first x, first y, last x, last y.
+		glm::ivec4 getRange(size_t layerIndex, const glm::vec4& view, int margin) const;
+		bool isInRange(uint64_t key, const std::vector<glm::ivec4>& ranges) const;
+		BuiltChunk build(uint64_t key);
+		void upload(const BuiltChunk& built);
+		// Writes tiles in the chunk local area (first x, first y, last x, last y) to the lookup textures.
+		void flush(uint64_t key, Chunk& chunk, const glm::ivec4& area);
+		void run();
+
+		std::vector< std::shared_ptr<TileLayer> >			m_layers;
+		std::vector<TilesetInfo>							m_tilesets;
+		std::vector< std::shared_ptr<texture::Texture> >	m_tilesetTextures;
+		size2d_t											m_tileSize;
+		std::unordered_map<uint64_t, Chunk>					m_loaded;	// Uploaded chunks
+		std::unordered_map<uint64_t, BuiltChunk>			m_ready;	// Built chunks waiting for upload
+		std::unordered_map<uint64_t, glm::ivec4>			m_dirty;	// Edited area of chunks: first x, first y, last x, last y
+		std::unordered_map<uint64_t, uint64_t>				m_edited;	// Revision of the last edit of chunks, until builds started before it are taken
+		// Tiles are read by the background thread and written by setTile:
+		std::mutex											m_tilesMutex;
+		uint64_t											m_revision = 0;	// Number of edits
+		uint64_t											m_scrolled = 0;	// Revision of the last scroll, older chunks are stale
+		// Shared with the background thread:
+		std::mutex											m_mutex;
+		std::condition_variable								m_wakeUp;
+		std::deque<uint64_t>								m_requests;	// Chunks to build, nearest first
+		std::vector<BuiltChunk>								m_built;	// Built chunks not yet taken by update
+		uint64_t											m_building = NOT_BUILDING;
+		bool												m_quit = false;
+		std::thread											m_thread;
+	};
+
+} // End - namespace map
+} // End - namespace hungerland
@@ -0,0 +1,156 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#pragma once
+#include <hungerland/math.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace hungerland {
+namespace map {
+	class Map;
+}
+namespace clearance {
+
+	///
+	/// \brief The hungerland::clearance::Field class
+	///
+	/// Signed distance field of a tile layer, baked once from the map. Tiles with id > 0 are solid.
+	/// Each tile stores exact euclidean distance from its center to the nearest tile of the other
+	/// kind (solid for free tiles, free for solid tiles) in 1/128 tile fixed point. Distances are
+	/// positive outside and negative inside solid tiles, so surface between them is at distance 0.
+	/// Tiles outside of the map count as solid.
+	///
+	/// For a layer of walls the field tells distance to walls. For a layer of road the field tells
+	/// (negated) distance to the road edge.
+	///
+	/// @ingroup hungerland::clearance
+	///
+	class Field {
+	public:
+		static constexpr float SCALE = 128.0f;	// Fixed point units per tile.
+
+		Field() = default;
+
+		///
+		/// \brief bake Computes distance field of given layer with separable exact distance transform.
+		/// \param map
+		/// \param layerId	= Index of the layer, see Map::getLayerIndex.
+		/// \return Baked field.
+		///
+		static Field bake(const map::Map& map, size_t layerId);
+
+		///
+		/// \brief view Creates field of already baked distances, e.g. from memory mapped cooked map.
+		/// \param size		= Size of the field in tiles.
+		/// \param distances	= size.x*size.y distances in row major order, as returned by getData.
+		/// \return Field sharing the distances.
+		///
+		static Field view(const size2d_t& size, std::shared_ptr<int16_t> distances);
+
+		///
+		/// \brief bakeColumns Bakes distances again after tiles of columns x0..x1-1 changed. Only columns within the
+		/// largest distance of the field from the changed columns are baked, as other tiles can not have their
+		/// nearest tile of the other kind in them.
+		/// \param map
+		/// \param layerId	= Index of the layer, see Map::getLayerIndex.
+		/// \param x0, x1	= Changed columns. May reach outside of the map, e.g. for columns scrolled out of it.
+		///
+		void bakeColumns(const map::Map& map, size_t layerId, int x0, int x1);
+
+		///
+		/// \brief scroll Moves distances columns to the left after tiles of the layer were scrolled, see
+		/// TileData::scroll. Only columns near the left and right edge of the map are baked again.
+		/// \param map
+		/// \param layerId	= Index of the layer, see Map::getLayerIndex.
+		/// \param columns	= Number of columns scrolled.
+		///
+		void scroll(const map::Map& map, size_t layerId, size_t columns);
+
+		///
+		/// \brief setSolid Updates field after tile x,y changed to solid or free. Only tiles within the
+		/// largest distance of the field from x,y are visited, as other tiles can not get closer to the surface.
+		/// Changed tile and tiles, which get closer to the surface, get exact distances. Distances of
+		/// tiles, which get further from the surface, are not increased until the field is baked again,
+		/// so clearances of free tiles stay lower bounds. Copies of the field share changed distances,
+		/// but the field should be edited through one copy, which tracks the largest distance.
+		///
+		void setSolid(size_t x, size_t y, bool solid);
+
+		///
+		/// \brief getClearance
+		/// \param x	= Map x coordinate.
+		/// \param y	= Map y coordinate.
+		/// \return Lower bound of free distance from position to nearest solid tile in tiles. 0 inside solid tiles.
+		///
+		float getClearance(float x, float y) const;
+
+		///
+		/// \brief sample Bilinear sample of the signed distance field.
+		/// \param x	= Map x coordinate.
+		/// \param y	= Map y coordinate.
+		/// \return Approximate signed distance to surface of solid tiles in tiles.
+		///
+		float sample(float x, float y) const;
+
+		///
+		/// \brief getGradient
+		/// \param x	= Map x coordinate.
+		/// \param y	= Map y coordinate.
+		/// \return Gradient of the field pointing away from solid tiles, zero if field is flat.
+		///
+		glm::vec2 getGradient(float x, float y) const;
+
+		///
+		/// \brief getDistance
+		/// \return Signed distance from center of tile x,y to surface of solid tiles in tiles.
+		///
+		float getDistance(int x, int y) const;
+
+		const size2d_t& getSize() const {
+			return m_size;
+		}
+
+		bool isEmpty() const {
+			return m_distances == 0;
+		}
+
+		///
+		/// \brief getData
+		/// \return Fixed point distances (SCALE units per tile) in row major order.
+		///
+		const int16_t* getData() const {
+			return m_distances.get();
+		}
+
+	private:
+		int getRadius() const;
+
+		size2d_t						m_size = {0,0};
+		std::shared_ptr<int16_t>		m_distances;
+		int16_t							m_maxDistance = 0;	// Upper bound of absolute distances, limits updates.
+	};
+
+} // End - namespace clearance
+} // End - namespace hungerland
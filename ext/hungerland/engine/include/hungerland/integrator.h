@@ -0,0 +1,95 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#pragma once
+#include <hungerland/math.h>
+#include <vector>
+
+namespace hungerland {
+namespace integrator {
+	///
+	/// \brief The hungerland::integrator::Bodies class
+	///
+	/// Point bodies stored as structure of arrays for batch integration.
+	///
+	/// @ingroup hungerland::integrator
+	///
+	struct Bodies {
+		std::vector<float> px;
+		std::vector<float> py;
+		std::vector<float> vx;
+		std::vector<float> vy;
+		std::vector<float> fx;
+		std::vector<float> fy;
+
+		size_t size() const {
+			return px.size();
+		}
+
+		void clear() {
+			px.clear(); py.clear();
+			vx.clear(); vy.clear();
+			fx.clear(); fy.clear();
+		}
+
+		void push(const glm::vec2& position, const glm::vec2& velocity, const glm::vec2& force = glm::vec2(0)) {
+			px.push_back(position.x); py.push_back(position.y);
+			vx.push_back(velocity.x); vy.push_back(velocity.y);
+			fx.push_back(force.x); fy.push_back(force.y);
+		}
+	};
+
+	///
+	/// \brief The hungerland::integrator::Params class
+	///
+	/// @ingroup hungerland::integrator
+	///
+	struct Params {
+		glm::vec2	gravity = glm::vec2(0);		// Constant acceleration of all bodies.
+		float		drag = 0.0f;				// Linear velocity drag coefficient (1/s).
+		glm::vec2	boundsMin = glm::vec2(0);	// Bodies are clamped inside bounds and velocity towards the bound is zeroed.
+		glm::vec2	boundsMax = glm::vec2(0);
+	};
+
+	///
+	/// \brief integrate Integrates bodies with semi-implicit euler: v += (F + G - drag*v)*dt, p += v*dt.
+	/// Uses AVX or SSE when available and scalar code for the rest of bodies.
+	/// \param bodies
+	/// \param params
+	/// \param dt
+	///
+	void integrate(Bodies& bodies, const Params& params, float dt);
+
+	///
+	/// \brief integrateScalar Scalar version of integrate for bodies in range [begin, end).
+	/// \param bodies
+	/// \param params
+	/// \param dt
+	/// \param begin
+	/// \param end
+	///
+	void integrateScalar(Bodies& bodies, const Params& params, float dt, size_t begin, size_t end);
+
+} // End - namespace integrator
+
+} // End - namespace hungerland
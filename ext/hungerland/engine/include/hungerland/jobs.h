@@ -0,0 +1,181 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace hungerland {
+namespace jobs {
+	typedef std::function<void()> JobFunc;
+
+	class JobSystem;
+
+	///
+	/// \brief The hungerland::jobs::Counter class
+	///
+	/// Dependency counter of jobs. Each job started with a counter increments it and
+	/// decrements it when finished. Jobs started with JobSystem::runAfter are kept
+	/// waiting until the counter reaches zero.
+	///
+	/// @ingroup hungerland::jobs
+	///
+	class Counter {
+	public:
+		Counter() = default;
+
+		///
+		/// \brief isDone
+		/// \return true, if all jobs using this counter have finished.
+		///
+		bool isDone() const;
+
+	private:
+		friend class JobSystem;
+		struct Continuation {
+			JobFunc		func;
+			Counter*	counter;
+		};
+		std::atomic<int>			m_value = 0;
+		mutable std::mutex			m_mutex;
+		std::vector<Continuation>	m_continuations;
+
+		// Copy not allowed
+		Counter(const Counter&) = delete;
+		Counter& operator=(const Counter&) = delete;
+	};
+
+	///
+	/// \brief The hungerland::jobs::JobSystem class
+	///
+	/// Worker pool with one job queue per worker. Workers pop jobs from the back
+	/// of their own queue and steal from the front of other queues when empty.
+	/// Threads waiting for a counter help executing jobs meanwhile.
+	///
+	/// @ingroup hungerland::jobs
+	///
+	class JobSystem {
+	public:
+		///
+		/// \brief JobSystem
+		/// \param numWorkers = Number of worker threads. 0 uses hardware concurrency - 1.
+		///
+		explicit JobSystem(size_t numWorkers = 0);
+		~JobSystem();
+
+		///
+		/// \brief getNumWorkers
+		/// \return Number of worker threads. 0 means that all jobs run on the calling thread.
+		///
+		size_t getNumWorkers() const;
+
+		///
+		/// \brief run
+		/// \param job		= Job to run.
+		/// \param counter	= Optional counter, which is decremented when the job finishes.
+		///
+		void run(JobFunc job, Counter* counter = 0);
+
+		///
+		/// \brief runAfter
+		/// \param dependency	= Job is started when the dependency counter reaches zero.
+		/// \param job			= Job to run.
+		/// \param counter		= Optional counter, which is decremented when the job finishes.
+		///
+		void runAfter(Counter& dependency, JobFunc job, Counter* counter = 0);
+
+		///
+		/// \brief wait Executes jobs on the calling thread until the counter reaches zero.
+		/// \param counter
+		///
+		void wait(Counter& counter);
+
+		///
+		/// \brief parallelFor Splits range [begin,end) to chunks of grainSize and runs func(chunkBegin, chunkEnd) for each chunk.
+		/// \param begin
+		/// \param end
+		/// \param grainSize	= Maximum number of indices in one job.
+		/// \param func			= f(size_t begin, size_t end) -> void
+		///
+		template<typename Func>
+		void parallelFor(size_t begin, size_t end, size_t grainSize, Func func) {
+			if(end <= begin) {
+				return;
+			}
+			grainSize = std::max<size_t>(grainSize, 1);
+			if(getNumWorkers() == 0 || (end - begin) <= grainSize) {
+				func(begin, end);
+				return;
+			}
+			Counter counter;
+			for(auto i = begin; i < end; i += grainSize) {
+				const auto last = std::min(end, i + grainSize);
+				run([&func, i, last]() {
+					func(i, last);
+				}, &counter);
+			}
+			wait(counter);
+		}
+
+	private:
+		struct Job {
+			JobFunc		func;
+			Counter*	counter;
+		};
+
+		struct Queue {
+			std::mutex			mutex;
+			std::deque<Job>		jobs;
+		};
+
+		void push(Job job);
+		bool pop(size_t queueIndex, Job& job);
+		bool steal(size_t queueIndex, Job& job);
+		bool tryExecute(size_t queueIndex);
+		void execute(Job& job);
+		void finish(Counter& counter);
+		void workerMain(size_t workerIndex);
+
+		std::vector< std::unique_ptr<Queue> >	m_queues;
+		std::vector<std::thread>				m_workers;
+		std::atomic<size_t>						m_nextQueue = 0;
+		std::atomic<size_t>						m_numQueued = 0;
+		std::atomic<bool>						m_quit = false;
+		std::mutex								m_sleepMutex;
+		std::condition_variable					m_sleepCondition;
+
+		// Copy not allowed
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+	};
+
+} // End - namespace jobs
+
+} // End - namespace hungerland
@@ -25,13 +25,14 @@
 #include <hungerland/types.h>
 #include <hungerland/math.h>
 #include <hungerland/texture.h>
+#include <hungerland/clearance.h>
+#include <hungerland/objects.h>
+#include <hungerland/rects.h>
+#include <algorithm>
 #include <map>
-
-namespace tmx {
-	class TileLayer;
-	class ImageLayer;
-	class Map;
-}
+#include <vector>
+#include <cstdint>
+#include <assert.h>
 
 namespace hungerland {
 	namespace shader {
@@ -45,10 +46,15 @@ namespace hungerland {
 	namespace mesh {
 		class Mesh;
 	}
+	namespace jobs {
+		class JobSystem;
+	}
 }
 
 namespace hungerland {
 namespace map {
+	class ChunkStreamer;
+
 	struct LayerSubset {
 		float opacity = 1.0f;
 		int2d_t offset = {0,0};
@@ -80,38 +86,349 @@ namespace map {
 		size2d_t repeat;
 	};
 
+	///
+	/// \brief The TileData class. Tiles of a tile layer in one contiguous row major buffer.
+	/// Each tile is packed to 16 bits: global tile id in low 13 bits and tmx flip flags in high 3 bits.
+	/// Tiles are shared between copies, and may live in memory mapped cooked map file.
+	///
+	class TileData {
+	public:
+		static constexpr uint16_t	ID_BITS = 13;
+		static constexpr uint16_t	ID_MASK = (1 << ID_BITS) - 1;
+		static constexpr int		MAX_ID = ID_MASK;
+
+		TileData()
+			: TileData(0, 0) {
+		}
+
+		TileData(size_t width, size_t height)
+			: m_width(width)
+			, m_height(height)
+			, m_tiles(new uint16_t[width*height](), std::default_delete<uint16_t[]>()) {
+		}
+
+		///
+		/// \brief TileData Creates layer of existing packed tiles.
+		/// \param tiles	= width*height packed tiles in row major order, as returned by getData.
+		///
+		TileData(size_t width, size_t height, std::shared_ptr<uint16_t> tiles)
+			: m_width(width)
+			, m_height(height)
+			, m_tiles(tiles) {
+		}
+
+		bool contains(size_t x, size_t y) const {
+			return x < m_width && y < m_height;
+		}
+
+		///
+		/// \brief getId
+		/// \return Global tile id at x,y, 0 for empty tile. Position must be inside the layer.
+		///
+		int getId(size_t x, size_t y) const {
+			return m_tiles.get()[y*m_width + x] & ID_MASK;
+		}
+
+		///
+		/// \brief getFlags
+		/// \return Flip flags of tile at x,y as in tmx::TileLayer::FlipFlag.
+		///
+		int getFlags(size_t x, size_t y) const {
+			return (m_tiles.get()[y*m_width + x] >> ID_BITS) << 1;
+		}
+
+		void set(size_t x, size_t y, int id, int flipFlags) {
+			assert(contains(x, y) && id >= 0 && id <= MAX_ID);
+			m_tiles.get()[y*m_width + x] = uint16_t((id & ID_MASK) | (((flipFlags >> 1) & 0x7) << ID_BITS));
+		}
+
+		///
+		/// \brief scroll Moves tiles columns to the left. Tiles moved over the left edge are lost and
+		/// emptied columns at the right edge are empty tiles.
+		///
+		void scroll(size_t columns) {
+			columns = std::min(columns, m_width);
+			auto* tiles = m_tiles.get();
+			for(size_t y = 0; y < m_height; ++y) {
+				auto* row = tiles + y*m_width;
+				std::copy(row + columns, row + m_width, row);
+				std::fill(row + m_width - columns, row + m_width, uint16_t(0));
+			}
+		}
+
+		size_t getWidth() const {
+			return m_width;
+		}
+
+		size_t getHeight() const {
+			return m_height;
+		}
+
+		const uint16_t* getData() const {
+			return m_tiles.get();
+		}
+
+	private:
+		size_t						m_width;
+		size_t						m_height;
+		std::shared_ptr<uint16_t>	m_tiles;
+	};
+
+	///
+	/// \brief The TilesetInfo class. Tileset data used after loading.
+	///
+	struct TilesetInfo {
+		std::string	imagePath;
+		uint32_t	firstGID = 0;
+		uint32_t	tileCount = 0;
+		uint32_t	columns = 0;
+		size2d_t	tileSize = {0,0};
+	};
+
+	///
+	/// \brief The LayerInfo class. Layer data used after loading.
+	///
+	struct LayerInfo {
+		enum Type {
+			TILE = 0,
+			IMAGE = 1,
+		};
+		std::string	name;
+		Type		type = TILE;
+		float		opacity = 1.0f;
+		int2d_t		offset = {0,0};
+		// Image layers only:
+		std::string	imagePath;
+		size2d_t	repeat = {0,0};
+		glm::vec2	parallaxFactor = {1,1};
+		bool		hasTransparency = false;
+		glm::vec4	transparentColor = glm::vec4(0);
+	};
+
+	///
+	/// \brief The TileLayer class. Tiles of a tile layer. Drawable chunks of the layer are streamed by ChunkStreamer.
+	///
 	class TileLayer {
 	public:
-		std::vector<size2d_t>	objects;
-		std::vector<TileSetSubset>	subsets;
-		std::vector< std::vector<int> > tileIds;
-		std::vector< std::vector<int> > tileFlags;
-		TileLayer(const tmx::Map& map, size_t layerIndex, const std::vector< std::shared_ptr<texture::Texture> >& tilesetTextures);
+		LayerInfo	info;
+		TileData	tiles;
+
+		TileLayer(const TileData& tiles, const LayerInfo& info)
+			: info(info)
+			, tiles(tiles) {
+		}
 	};
 
 	class ImageLayer {
 	public:
 		ImageSubset subset;
-		const tmx::ImageLayer* tmxLayer;
-		ImageLayer(const tmx::Map& map, size_t layerIndex, const std::vector< std::shared_ptr<texture::Texture> >& mapTextures);
+		ImageLayer(const LayerInfo& info, std::shared_ptr<texture::Texture> texture, const glm::vec4& bounds);
+	};
+
+	///
+	/// \brief The DecodedImage class. Pixels of an image file decoded on CPU, waiting for texture creation.
+	///
+	struct DecodedImage {
+		unsigned				width = 0;
+		unsigned				height = 0;
+		unsigned				channels = 0;
+		std::vector<uint8_t>	pixels;	// width*height*channels bytes in row major order
 	};
 
+	///
+	/// \brief hungerland::map::decodeImage Decodes image file with stb_image. Thread safe.
+	/// \param fileName
+	/// \return Decoded image, or 0 if the file can't be loaded.
+	///
+	std::shared_ptr<DecodedImage> decodeImage(const std::string& fileName);
+
 	///
 	/// \brief The hungerland::map::Map class
 	///
 	class Map {
 	public:
 		typedef std::function<std::shared_ptr<texture::Texture>(const std::string&)> LoadTextureFuncType;
-
+		typedef std::function<std::shared_ptr<DecodedImage>(const std::string&)> DecodeImageFuncType;
+		typedef std::function<std::shared_ptr<texture::Texture>(const std::string&, const DecodedImage&)> CreateTextureFuncType;
+
+		///
+		/// \brief Map Loads textures one by one on the calling thread.
+		/// \param mapFilename = Tiled map (.tmx) or cooked map (COOKED_EXTENSION) file, see cook.
+		/// \param loadTexture = Texture loading function. If empty, map is loaded without graphics (tile data only) and no GL context is needed.
+		///
 		Map(const std::string& mapFilename, LoadTextureFuncType loadTexture);
 
+		///
+		/// \brief Map Loads map in parallel. After the map file is read, jobs decode each image file once and bake
+		/// distance fields of tile layers, so load time is bounded by the largest of them. Textures are created
+		/// on the calling thread in one batch at the end.
+		/// \param mapFilename		= Tiled map (.tmx) or cooked map (COOKED_EXTENSION) file, see cook.
+		/// \param decodeImage		= Image decoding function, called from worker threads, so it must be thread safe. See decodeImage.
+		/// \param createTexture	= Texture creating function, called from the calling thread. If empty, map is loaded without graphics.
+		/// \param jobSystem		= Job system running the jobs. If 0, a job system is created for loading.
+		///
+		Map(const std::string& mapFilename, DecodeImageFuncType decodeImage, CreateTextureFuncType createTexture, jobs::JobSystem* jobSystem = 0);
+
+		static constexpr const char*	COOKED_EXTENSION = ".hlmap";
+		static constexpr uint32_t		COOKED_VERSION = 2;
+
+		///
+		/// \brief cook Writes map to versioned binary file, which loads with memory mapping and without parsing.
+		/// File holds tile layers as packed tiles, distance fields, surfaces, objects, layer names and tileset data.
+		/// Paths of images are stored as they were loaded, so cooked map must be loaded from the same
+		/// working directory as the original map.
+		/// \param fileName
+		///
+		void cook(const std::string& fileName) const;
+
+		///
+		/// \brief hasGraphics
+		/// \return true, if map has textures and shaders for drawing.
+		///
+		bool hasGraphics() const;
+
 		size2d_t getMapSize() const;
 		size2d_t getTileSize() const;
 		const size_t getNumLayers() const;
 		size_t getLayerIndex(const std::string& name) const;
 
+		///
+		/// \brief The LayerHandle class. Tile layer resolved once by getLayerHandle, e.g. after the map is loaded.
+		/// Accessors taking a handle skip lookups by layer name and layer index, so per frame code should use them.
+		/// Handle is valid only for the map which resolved it.
+		///
+		struct LayerHandle {
+			static constexpr uint32_t INVALID = 0xffffffffu;
+			uint32_t	layerId = INVALID;		// Index of the layer, see getLayerIndex
+			uint32_t	tileLayerId = INVALID;	// Index of the tile layer, see getTileLayers
+
+			bool isValid() const {
+				return tileLayerId != INVALID;
+			}
+		};
+
+		///
+		/// \brief getLayerHandle
+		/// \param name	= Name of a tile layer. Missing layer is an error, like in getLayerIndex.
+		/// \return Handle of the tile layer.
+		///
+		LayerHandle getLayerHandle(const std::string& name) const;
+
+		///
+		/// \brief getLayerHandle
+		/// \param layerId	= Index of a tile layer, see getLayerIndex.
+		/// \return Handle of the tile layer.
+		///
+		LayerHandle getLayerHandle(size_t layerId) const;
+
 		const int getTileId(size_t layerId, size_t x, size_t y) const;
 
+		///
+		/// \brief getTileId
+		/// \param layer	= Tile layer, see getLayerHandle.
+		/// \param x, y		= Tile coordinates.
+		/// \return Global tile id, 0 for empty tile and -1 outside of the map.
+		///
+		int getTileId(LayerHandle layer, int x, int y) const {
+			assert(layer.tileLayerId < m_layerTiles.size());
+			const auto& tiles = m_layerTiles[layer.tileLayerId];
+			if(x < 0 || y < 0 || false == tiles.contains(size_t(x), size_t(y))) {
+				return -1;
+			}
+			return tiles.getId(size_t(x), size_t(y));
+		}
+
+		///
+		/// \brief setTile Changes tile of a tile layer at runtime. Tiles of loaded chunks are written to GL on next draw,
+		/// by updating only the edited area of their lookup textures. Distance field of the layer is updated,
+		/// if the tile changes between empty and solid, see clearance::Field::setSolid, and collision rectangles of its row
+		/// are meshed again, see rects::RectSet::bakeArea.
+		/// \param layerId		= Index of tile layer.
+		/// \param x, y			= Tile coordinates. Tiles outside of the map are ignored.
+		/// \param tileId		= Global tile id, 0 for empty tile.
+		/// \param flipFlags	= Flips of the tile as in TileData::getFlags.
+		///
+		void setTile(size_t layerId, size_t x, size_t y, int tileId, int flipFlags = 0);
+		void setTile(LayerHandle layer, size_t x, size_t y, int tileId, int flipFlags = 0);
+
+		///
+		/// \brief setTiles Changes a rectangle of tiles of a tile layer at once, e.g. a generated chunk. Like setTile,
+		/// but distance field and collision rectangles of the layer are baked again once after all tiles are written,
+		/// only near the changed columns and in the changed area, see clearance::Field::bakeColumns and rects::RectSet::bakeArea.
+		/// \param layerId	= Index of tile layer.
+		/// \param x, y		= Tile coordinates of the top left tile. Tiles outside of the map are ignored.
+		/// \param tiles	= Tiles to write, with their flip flags.
+		///
+		void setTiles(size_t layerId, size_t x, size_t y, const TileData& tiles);
+		void setTiles(LayerHandle layer, size_t x, size_t y, const TileData& tiles);
+
+		///
+		/// \brief scrollTiles Moves tiles of all tile layers columns to the left and empties columns at the right edge,
+		/// so that an endless level fits to a map of fixed size. Drawable chunks are rebuilt. Distance fields and
+		/// collision rectangles are moved with the tiles, and baked again only near the edges of the map. Objects are not moved.
+		/// \param columns	= Number of columns to scroll.
+		///
+		void scrollTiles(size_t columns);
+
+		///
+		/// \brief getRevision
+		/// \return Number of tile changes since the map was loaded. Data derived from tiles, like navigation
+		/// grids or collision shapes, is up to date, if the revision has not changed since it was built.
+		///
+		uint64_t getRevision() const {
+			return m_revision;
+		}
+
+		///
+		/// \brief getClearance
+		/// \param layerId	= Index of tile layer.
+		/// \return Signed distance field of the layer, baked when the map was loaded.
+		///
+		const clearance::Field& getClearance(size_t layerId) const;
+
+		const clearance::Field& getClearance(LayerHandle layer) const {
+			assert(layer.tileLayerId < m_clearances.size());
+			return m_clearances[layer.tileLayerId];
+		}
+
+		///
+		/// \brief getCollisionRects
+		/// \param layerId	= Index of tile layer.
+		/// \return Solid tiles of the layer merged to rectangles, baked when the map was loaded and updated by setTile.
+		///
+		const rects::RectSet& getCollisionRects(size_t layerId) const;
+
+		const rects::RectSet& getCollisionRects(LayerHandle layer) const {
+			assert(layer.tileLayerId < m_collisionRects.size());
+			return m_collisionRects[layer.tileLayerId];
+		}
+
+		///
+		/// \brief The Surface class. Physical properties of a tile, read from tile properties of the tilesets.
+		///
+		struct Surface {
+			float	friction = 1.0f;	// Multiplier of ground friction, tile property "friction".
+			float	speed = 1.0f;		// Multiplier of driving force, tile property "speed".
+			float	damage = 0.0f;		// Damage per second, tile property "damage".
+		};
+
+		///
+		/// \brief getSurface
+		/// \param tileId	= Global tile id, see getTileId.
+		/// \return Surface properties of the tile. Empty tiles and tiles without properties have default surface.
+		///
+		const Surface& getSurface(int tileId) const {
+			return (tileId > 0 && size_t(tileId) < m_surfaces.size()) ? m_surfaces[tileId] : m_surfaces[0];
+		}
+
+		///
+		/// \brief getObjects
+		/// \return Objects of all object layers, with spatial index for area and point queries.
+		///
+		const objects::ObjectSet& getObjects() const {
+			return m_objects;
+		}
+
 		const auto& getImageLayers() const {
 			return m_bgLayers;
 		}
@@ -131,21 +448,121 @@ namespace map {
 		typedef std::vector< std::vector<glm::vec3> > MapCollision;
 
 		MapCollision checkCollision(const std::string& layerName, const glm::vec3 position, glm::vec3 halfSize) const;
+		MapCollision checkCollision(LayerHandle layer, const glm::vec3 position, glm::vec3 halfSize) const;
+
+		///
+		/// \brief The Contact class
+		///
+		struct Contact {
+			bool		hit = false;
+			glm::vec2	normal = glm::vec2(0);	// Unit vector pushing body out of the tiles.
+			float		depth = 0.0f;			// Penetration depth along normal.
+		};
+
+		///
+		/// \brief checkCollisionOBB Tests oriented box against solid tiles of layer with separating axis test.
+		/// Only collision rectangles (see getCollisionRects) overlapped by bounds of the rotated box are tested.
+		/// Tiles outside of the map are solid.
+		/// \param layerName	= Name of the collision layer.
+		/// \param position		= Center of the box.
+		/// \param halfSize		= Half size of the box in its local frame.
+		/// \param angle		= Rotation of the box in radians.
+		/// \return Contact with largest penetration depth and sum normal of all contacts.
+		///
+		Contact checkCollisionOBB(const std::string& layerName, const glm::vec2& position, const glm::vec2& halfSize, float angle) const;
+		Contact checkCollisionOBB(LayerHandle layer, const glm::vec2& position, const glm::vec2& halfSize, float angle) const;
+
+		///
+		/// \brief The BoxQuery class. Axis aligned box of batched collision query.
+		///
+		struct BoxQuery {
+			glm::vec2	position = glm::vec2(0);
+			glm::vec2	halfSize = glm::vec2(0);
+		};
+
+		///
+		/// \brief checkCollisions Tests many axis aligned boxes against solid tiles of layer in one pass.
+		/// Queries are visited in order of tile rows and overlaps of boxes and collision rectangles
+		/// (see getCollisionRects) are computed several at a time.
+		/// Tiles outside of the map are solid.
+		/// \param layerId	= Index of the collision layer, see getLayerIndex.
+		/// \param queries	= Boxes to test.
+		/// \param count	= Number of queries.
+		/// \param results	= Contact of each query, written in same order as queries.
+		///
+		void checkCollisions(size_t layerId, const BoxQuery* queries, size_t count, Contact* results) const;
+		void checkCollisions(LayerHandle layer, const BoxQuery* queries, size_t count, Contact* results) const;
+
+		///
+		/// \brief The RayHit class
+		///
+		struct RayHit {
+			bool		hit = false;
+			float		distance = 0.0f;			// Distance to first hit tile or max distance, if not hit.
+			glm::vec2	normal = glm::vec2(0);		// Normal of the hit tile edge. Zero, if ray starts inside hit tile.
+			int2d_t		tile = {0,0};				// Hit tile.
+		};
+
+		///
+		/// \brief raycast Travels tiles along the ray with DDA until a stopping tile is found.
+		/// Tiles outside of the map always stop the ray.
+		/// \param layerId		= Index of the tile layer, see getLayerIndex.
+		/// \param origin		= Start of the ray in map coordinates.
+		/// \param direction	= Unit direction of the ray.
+		/// \param maxDistance	= Maximum length of the ray in tiles.
+		/// \param hitEmpty		= If false, ray stops at solid tiles (walls). If true, ray stops at empty tiles (e.g. edge of road).
+		/// \return First hit.
+		///
+		RayHit raycast(size_t layerId, const glm::vec2& origin, const glm::vec2& direction, float maxDistance, bool hitEmpty = false) const;
+		RayHit raycast(LayerHandle layer, const glm::vec2& origin, const glm::vec2& direction, float maxDistance, bool hitEmpty = false) const;
+
+		///
+		/// \brief raycastSensors Casts numRays rays for each of numAgents agents in one call.
+		/// Rays are stepped in lock step as structure of arrays, so that work is shared evenly over rays.
+		/// \param layerId		= Index of the tile layer, see getLayerIndex.
+		/// \param origins		= Origin of each agent.
+		/// \param headings		= Heading angle of each agent in radians.
+		/// \param numAgents
+		/// \param rayAngles	= Angle of each ray relative to the heading in radians.
+		/// \param numRays
+		/// \param maxDistance	= Maximum length of the rays in tiles.
+		/// \param hits			= Result of each ray, numAgents*numRays elements. Rays of agent a start from a*numRays.
+		/// \param hitEmpty		= See raycast.
+		///
+		void raycastSensors(size_t layerId, const glm::vec2* origins, const float* headings, size_t numAgents,
+			const float* rayAngles, size_t numRays, float maxDistance, RayHit* hits, bool hitEmpty = false) const;
+		void raycastSensors(LayerHandle layer, const glm::vec2* origins, const float* headings, size_t numAgents,
+			const float* rayAngles, size_t numRays, float maxDistance, RayHit* hits, bool hitEmpty = false) const;
 
 
 	public:
 		std::shared_ptr<shader::Shader>						m_tileLayerShader;
 		std::shared_ptr<shader::Shader>						m_imageLayerShader;
+		std::shared_ptr<ChunkStreamer>						m_chunkStreamer;	// Drawable chunks of tile layers, if map has graphics
 		//std::shared_ptr<mesh::Mesh>							m_mapMesh;
 	private:
+		// Loaders fill map data and tiles of each tile layer:
+		void loadTmx(const std::string& mapFilename, std::vector<TileData>& layerTiles);
+		void loadCooked(const std::string& mapFilename, std::vector<TileData>& layerTiles);
+
 		glm::vec4											m_clearColor;
-		std::shared_ptr<tmx::Map>							m_map;
+		size2d_t											m_mapSize = {0,0};
+		size2d_t											m_tileSize = {0,0};
+		glm::vec4											m_bounds = glm::vec4(0);	// Left, top, width and height in pixels
+		std::vector< TilesetInfo >							m_tilesets;
+		std::vector< LayerInfo >							m_layerInfos;	// Info of each layer in m_allLayersMap
 		std::vector< std::shared_ptr<texture::Texture> >	m_tilesetTextures;
 		std::vector< std::shared_ptr<texture::Texture> >	m_imageTextures;
 		std::vector< std::shared_ptr<TileLayer> >			m_tileLayers;
+		std::vector< TileData >								m_layerTiles; // Tiles of each tile layer, sharing storage with m_tileLayers
+		std::vector< clearance::Field >						m_clearances; // Distance fields of tile layers
+		std::vector< rects::RectSet >						m_collisionRects; // Solid rectangles of tile layers
+		std::vector< Surface >								m_surfaces = {Surface()}; // Surface of each global tile id
+		objects::ObjectSet									m_objects;
 		std::vector< std::shared_ptr<ImageLayer> >			m_bgLayers;
 		std::map<std::string, size_t> m_layerNames;
 		std::vector< std::array<size_t,2> > m_allLayersMap;
+		uint64_t											m_revision = 0;	// Number of tile changes
 	};
 
 
@@ -224,6 +641,37 @@ namespace map {
 		});
 	}
 
+	///
+	/// \brief hungerland::map::load Loads map in parallel, see Map.
+	/// \param decodeImage		= f(const std::string&) -> std::shared_ptr<DecodedImage>. Must be thread safe.
+	/// \param createTexture	= f(const std::string&, const DecodedImage&) -> std::shared_ptr<texture::Texture>
+	/// \param mapFile
+	///
+	template<typename MapType, typename DecodeImageFunc, typename CreateTextureFunc>
+	std::shared_ptr<MapType> load(DecodeImageFunc decodeImage, CreateTextureFunc createTexture, const std::string& mapFile, bool repeat) {
+		return std::make_shared<MapType>(mapFile, decodeImage, [createTexture,repeat](const std::string& imageFile, const DecodedImage& image) {
+			auto texture = createTexture(imageFile, image);
+			texture->setRepeat(repeat);
+			return texture;
+		});
+	}
+
+	///
+	/// \brief hungerland::map::findCooked
+	/// \param mapFile	= Tiled map file.
+	/// \return Cooked map file next to the map file, if it exists and is not older than the map file. Otherwise the map file.
+	///
+	std::string findCooked(const std::string& mapFile);
+
+	///
+	/// \brief hungerland::map::loadHeadless Loads map without graphics. Usable without window and GL context.
+	/// \param mapFile
+	///
+	template<typename MapType>
+	std::shared_ptr<MapType> loadHeadless(const std::string& mapFile) {
+		return std::make_shared<MapType>(mapFile, typename MapType::LoadTextureFuncType());
+	}
+
 	///
 	/// \brief render
 	/// \param map
@@ -0,0 +1,76 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace hungerland {
+namespace util {
+
+	///
+	/// \brief The hungerland::util::MappedFile class
+	///
+	/// File mapped to memory (mmap on POSIX, file mapping on Windows). Pages are mapped copy on write:
+	/// memory can be modified, but changes are private to the process and never written to the file.
+	/// The mapping stays alive as long as any shared_ptr to it (or aliasing shared_ptr to its data) exists.
+	///
+	/// @ingroup hungerland::util
+	///
+	class MappedFile {
+	public:
+		///
+		/// \brief open
+		/// \param fileName
+		/// \return Mapped file or null, if file can't be opened or mapped.
+		///
+		static std::shared_ptr<MappedFile> open(const std::string& fileName);
+
+		~MappedFile();
+
+		uint8_t* getData() const {
+			return m_data;
+		}
+
+		size_t getSize() const {
+			return m_size;
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+	private:
+		MappedFile() = default;
+
+		uint8_t*	m_data = 0;
+		size_t		m_size = 0;
+#if defined(_WIN32)
+		void*		m_file = 0;
+		void*		m_mapping = 0;
+#endif
+	};
+
+} // End - namespace util
+} // End - namespace hungerland
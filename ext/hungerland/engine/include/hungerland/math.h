@@ -24,6 +24,8 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
 
 namespace hungerland {
 	struct size2d_t {
@@ -35,4 +37,77 @@ namespace hungerland {
 		int x;
 		int y;
 	};
+
+///
+/// Deterministic trigonometry. Results depend only on IEEE float arithmetic, not on the C library,
+/// so simulations using these give bit identical results on all platforms (when compiled without
+/// floating point contraction, see HUNGERLAND_STRICT_FP). Absolute error is below 1e-6 for sin, cos
+/// and atan2.
+///
+namespace math {
+	///
+	/// \brief sincos
+	/// \param angle	= Angle in radians.
+	/// \param s		= Sine of the angle.
+	/// \param c		= Cosine of the angle.
+	///
+	inline void sincos(float angle, float& s, float& c) {
+		// Reduce to [-pi/4, pi/4] with pi/2 split to high and low parts (Cody-Waite):
+		const float TWO_OVER_PI = 0.636619772367581f;
+		const float PIO2_HI = 1.57079637050628662109375f;
+		const float PIO2_LO = -4.37113900018624283e-8f;
+		const float q = std::floor(angle*TWO_OVER_PI + 0.5f);
+		const float x = (angle - q*PIO2_HI) - q*PIO2_LO;
+		const float z = x*x;
+		// Minimax polynomials (Cephes sinf/cosf):
+		const float sx = x + x*z*(-1.6666654611e-1f + z*(8.3321608736e-3f + z*(-1.9515295891e-4f)));
+		const float cx = 1.0f - 0.5f*z + z*z*(4.166664568298827e-2f + z*(-1.388731625493765e-3f + z*2.443315711809948e-5f));
+		switch(int(q - 4.0f*std::floor(q*0.25f))) {
+		case 0:		s = sx;		c = cx;		break;
+		case 1:		s = cx;		c = -sx;	break;
+		case 2:		s = -sx;	c = -cx;	break;
+		default:	s = -cx;	c = sx;		break;
+		}
+	}
+
+	inline float sin(float angle) {
+		float s, c;
+		sincos(angle, s, c);
+		return s;
+	}
+
+	inline float cos(float angle) {
+		float s, c;
+		sincos(angle, s, c);
+		return c;
+	}
+
+	///
+	/// \brief atan2
+	/// \return Angle of vector (x,y) in radians in range [-pi, pi].
+	///
+	inline float atan2(float y, float x) {
+		const float PI = 3.14159265358979f;
+		const float ax = std::abs(x), ay = std::abs(y);
+		if(ax == 0.0f && ay == 0.0f) {
+			return 0.0f;
+		}
+		// atan of ratio in [0,1], reduced further to [-tan(pi/8), tan(pi/8)] (Cephes atanf):
+		float t = std::min(ax, ay) / std::max(ax, ay);
+		float base = 0.0f;
+		if(t > 0.4142135623730950f) {
+			base = 0.25f*PI;
+			t = (t - 1.0f) / (t + 1.0f);
+		}
+		const float z = t*t;
+		float a = base + ((((8.05374449538e-2f*z - 1.38776856032e-1f)*z + 1.99777106478e-1f)*z - 3.33329491539e-1f)*z*t + t);
+		if(ay > ax) {
+			a = 0.5f*PI - a;
+		}
+		if(x < 0.0f) {
+			a = PI - a;
+		}
+		return std::signbit(y) ? -a : a;
+	}
+} // End - namespace math
 }
@@ -0,0 +1,167 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#pragma once
+#include <hungerland/math.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hungerland {
+namespace objects {
+
+	///
+	/// \brief The hungerland::objects::Object class. Object of an object layer, like spawn point, checkpoint or trigger area.
+	///
+	struct Object {
+		std::string_view	name;
+		std::string_view	type;			// Class of the object in Tiled
+		std::string_view	layer;			// Name of the object layer
+		glm::vec4			bounds = glm::vec4(0);	// Left, top, right and bottom in tiles. Tile x,y is centered at x,y as in clearance::Field.
+		uint32_t			id = 0;			// Unique id of the object in the map
+
+		glm::vec2 getCenter() const {
+			return glm::vec2(bounds.x + bounds.z, bounds.y + bounds.w) * 0.5f;
+		}
+	};
+
+	///
+	/// \brief The hungerland::objects::ObjectSet class
+	///
+	/// Objects of all object layers of a map in one flat array with a static packed Hilbert R-tree.
+	/// Objects are sorted by Hilbert curve index of their centers, so objects near each other are near
+	/// each other in memory too. Each node of the tree is the bounding box of NODE_SIZE consecutive
+	/// nodes of the level below, and the lowest level is the objects. Nodes are stored level by level
+	/// in one array of boxes, so the tree has no pointers and query cost is O(log n + number of hits).
+	/// Names are views to one shared string table, so copies of the set are cheap.
+	///
+	/// @ingroup hungerland::objects
+	///
+	class ObjectSet {
+	public:
+		static constexpr size_t NODE_SIZE = 16;	// Children of a tree node
+
+		///
+		/// \brief The ObjectInfo class. Object data owning its strings, used to build the set.
+		///
+		struct ObjectInfo {
+			std::string	name;
+			std::string	type;
+			std::string	layer;
+			glm::vec4	bounds = glm::vec4(0);
+			uint32_t	id = 0;
+		};
+
+		ObjectSet() = default;
+
+		///
+		/// \brief ObjectSet Sorts objects and builds the tree.
+		/// \param objects	= Objects in any order.
+		///
+		explicit ObjectSet(const std::vector<ObjectInfo>& objects);
+
+		///
+		/// \brief forEachOverlapping Calls f(const Object&) for each object, whose bounds overlap the area.
+		/// Edges touching each other overlap, so point objects are found by areas containing them.
+		/// \param area	= Left, top, right and bottom in tiles.
+		///
+		template<typename Func>
+		void forEachOverlapping(const glm::vec4& area, Func f) const {
+			if(m_objects.empty()) {
+				return;
+			}
+			// Depth first traversal with explicit stack of node indices. Each level pushes at most NODE_SIZE nodes.
+			std::array<uint32_t, NODE_SIZE*MAX_LEVELS> stack;
+			size_t stackSize = 0;
+			stack[stackSize++] = uint32_t(m_boxes.size() - 1);
+			while(stackSize > 0) {
+				const auto node = stack[--stackSize];
+				if(false == overlaps(m_boxes[node], area)) {
+					continue;
+				}
+				if(node < m_objects.size()) {
+					f(m_objects[node]);
+					continue;
+				}
+				const auto children = getChildren(node);
+				for(auto child = children.second; child > children.first; --child) {
+					stack[stackSize++] = child - 1;
+				}
+			}
+		}
+
+		///
+		/// \brief forEachAt Calls f(const Object&) for each object, whose bounds contain the point.
+		///
+		template<typename Func>
+		void forEachAt(const glm::vec2& point, Func f) const {
+			forEachOverlapping(glm::vec4(point, point), f);
+		}
+
+		///
+		/// \brief find
+		/// \return First object with given name, or 0 if there is none.
+		///
+		const Object* find(std::string_view name) const;
+
+		size_t size() const {
+			return m_objects.size();
+		}
+
+		bool empty() const {
+			return m_objects.empty();
+		}
+
+		const Object& operator[](size_t index) const {
+			return m_objects[index];
+		}
+
+		auto begin() const {
+			return m_objects.begin();
+		}
+
+		auto end() const {
+			return m_objects.end();
+		}
+
+	private:
+		static constexpr size_t MAX_LEVELS = 9;	// 16^8 objects at most
+
+		static bool overlaps(const glm::vec4& a, const glm::vec4& b) {
+			return a.x <= b.z && b.x <= a.z && a.y <= b.w && b.y <= a.w;
+		}
+
+		// First and end node index of children of an inner node.
+		std::pair<uint32_t, uint32_t> getChildren(uint32_t node) const;
+
+		std::vector<Object>				m_objects;		// Objects in tree order
+		std::vector<glm::vec4>			m_boxes;		// Bounds of all nodes level by level, objects first and root last
+		std::vector<uint32_t>			m_levelEnds;	// End node index of each level
+		std::shared_ptr<std::string>	m_strings;		// Names of the objects
+	};
+
+} // End - namespace objects
+} // End - namespace hungerland
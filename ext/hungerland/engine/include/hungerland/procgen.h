@@ -0,0 +1,149 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#pragma once
+#include <hungerland/map.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+struct stbhw_tileset;
+
+namespace hungerland {
+namespace procgen {
+
+	///
+	/// \brief The hungerland::procgen::WangTiles class
+	///
+	/// Herringbone Wang tile set of stb_herringbone_wang_tile. Tiles are painted by the user for every
+	/// combination of edge colors, so any pattern of tiles satisfies the edge constraints and generated
+	/// content joins seamlessly at the edges. Horizontal tiles are 2*sideLength x sideLength and
+	/// vertical tiles sideLength x 2*sideLength pixels, each pixel is a user defined byte.
+	/// Edges are indexed as in the edge constraints of stb_herringbone_wang_tile:
+	/// horizontal tile: 0 = top left, 1 = top right, 2 = left, 3 = right, 4 = bottom left, 5 = bottom right.
+	/// vertical tile: 0 = top, 1 = left top, 2 = right top, 3 = left bottom, 4 = right bottom, 5 = bottom.
+	///
+	/// @ingroup hungerland::procgen
+	///
+	class WangTiles {
+	public:
+		static constexpr int NUM_EDGES = 6;
+
+		///
+		/// \brief PaintFuncType f(bool isHorizontal, const int* edges, uint32_t variant, uint8_t* pixels) -> void
+		/// Paints one tile: NUM_EDGES edge colors, variant index and width*height pixels in row major order.
+		///
+		typedef std::function<void(bool, const int*, uint32_t, uint8_t*)> PaintFuncType;
+
+		///
+		/// \brief WangTiles Paints the tile set.
+		/// \param sideLength	= Length of the short side of tiles in pixels.
+		/// \param numColors	= Number of colors of each edge.
+		/// \param numVariants	= Number of tiles with the same edge colors.
+		/// \param paint		= Tile painting function.
+		///
+		WangTiles(int sideLength, int numColors, int numVariants, PaintFuncType paint);
+		~WangTiles();
+
+		///
+		/// \brief generate Fills pixels with a random pattern of tiles. Thread safe.
+		/// \param seed		= Same seed and size give the same pattern.
+		/// \param width	= Width of the pattern in pixels.
+		/// \param height	= Height of the pattern in pixels.
+		/// \param pixels	= width*height pixels in row major order.
+		/// \return false, if the pattern is too large for stb_herringbone_wang_tile.
+		///
+		bool generate(uint64_t seed, int width, int height, uint8_t* pixels) const;
+
+		int getSideLength() const {
+			return m_sideLength;
+		}
+
+		WangTiles(const WangTiles&) = delete;
+		WangTiles& operator=(const WangTiles&) = delete;
+
+	private:
+		int								m_sideLength;
+		std::unique_ptr<stbhw_tileset>	m_tileset;
+	};
+
+	///
+	/// \brief The hungerland::procgen::ChunkGenerator class
+	///
+	/// Generates chunks of tile layers with a background thread. Chunks are identified by an index,
+	/// e.g. distance from the start of an endless track in chunks. Users request chunks ahead of time
+	/// and take them with get when needed, which waits only if the chunk is not generated yet. So the
+	/// content and the time it appears in the game do not depend on thread timing.
+	///
+	/// @ingroup hungerland::procgen
+	///
+	class ChunkGenerator {
+	public:
+		typedef std::vector<map::TileData> Chunk;	// Tiles of each generated layer
+		typedef std::function<Chunk(int64_t)> GenerateFuncType;
+
+		///
+		/// \brief ChunkGenerator Starts the background thread.
+		/// \param generate	= f(int64_t index) -> Chunk. Called from the background thread.
+		///
+		explicit ChunkGenerator(GenerateFuncType generate);
+		~ChunkGenerator();
+
+		///
+		/// \brief request Queues chunk for generation, if it is not generated or queued already.
+		///
+		void request(int64_t index);
+
+		///
+		/// \brief get Takes generated chunk, waiting for it if needed. Chunk is generated, if it was not requested.
+		/// \param index
+		/// \return Tiles of each layer of the chunk.
+		///
+		Chunk get(int64_t index);
+
+		ChunkGenerator(const ChunkGenerator&) = delete;
+		ChunkGenerator& operator=(const ChunkGenerator&) = delete;
+
+	private:
+		static constexpr int64_t NOT_GENERATING = INT64_MIN;
+
+		bool isPending(int64_t index) const;
+		void run();
+
+		GenerateFuncType				m_generate;
+		// Shared with the background thread:
+		std::mutex						m_mutex;
+		std::condition_variable			m_wakeUp;		// Signaled when requests are added
+		std::condition_variable			m_generated;	// Signaled when a chunk is generated
+		std::deque<int64_t>				m_requests;		// Chunks to generate in order
+		std::map<int64_t, Chunk>		m_ready;		// Generated chunks not yet taken by get
+		int64_t							m_generating = NOT_GENERATING;
+		bool							m_quit = false;
+		std::thread						m_thread;
+	};
+
+} // End - namespace procgen
+} // End - namespace hungerland
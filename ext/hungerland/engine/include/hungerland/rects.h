@@ -0,0 +1,164 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#pragma once
+#include <hungerland/math.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace hungerland {
+namespace map {
+	class Map;
+}
+namespace rects {
+
+	///
+	/// \brief The hungerland::rects::Rect class. Axis aligned rectangle of whole tiles.
+	///
+	struct Rect {
+		int	x = 0;		// First tile x
+		int	y = 0;		// First tile y
+		int	width = 0;	// Width in tiles
+		int	height = 0;	// Height in tiles
+
+		///
+		/// \brief getCenter
+		/// \return Center in map coordinates, where tile x,y covers area [x-0.5, x+0.5].
+		///
+		glm::vec2 getCenter() const {
+			return glm::vec2(float(x) + 0.5f*float(width - 1), float(y) + 0.5f*float(height - 1));
+		}
+
+		glm::vec2 getHalfSize() const {
+			return glm::vec2(0.5f*float(width), 0.5f*float(height));
+		}
+	};
+
+	///
+	/// \brief The hungerland::rects::RectSet class
+	///
+	/// Solid tiles (id > 0) of a tile layer merged to rectangles with greedy meshing: each row is scanned
+	/// left to right, a rectangle grows from the first free solid tile as wide as possible and then as
+	/// tall as possible. Long walls become single boxes, so collision queries test few boxes and get no
+	/// contacts from seams between tiles of a wall. Rectangles are indexed by tile row: each row lists
+	/// rectangles covering it sorted by x, so a query finds its first rectangle in each row with binary search.
+	/// Edited tiles are meshed again locally with bakeArea, which keeps the rows of other rectangles as they are.
+	///
+	/// @ingroup hungerland::rects
+	///
+	class RectSet {
+	public:
+		RectSet() = default;
+
+		///
+		/// \brief bake Merges solid tiles of given layer to rectangles.
+		/// \param map
+		/// \param layerId	= Index of the layer, see Map::getLayerIndex.
+		/// \return Baked rectangles.
+		///
+		static RectSet bake(const map::Map& map, size_t layerId);
+
+		///
+		/// \brief bakeArea Merges solid tiles of area x0..x1, y0..y1 to rectangles again after its tiles changed.
+		/// Rectangles overlapping the area are cut to their parts outside of it, so only rows of the area and rows
+		/// of the cut rectangles are updated.
+		/// \param map
+		/// \param layerId	= Index of the layer, see Map::getLayerIndex.
+		/// \param x0, y0	= First tile of the area.
+		/// \param x1, y1	= Last tile of the area. Area is clipped to the map.
+		///
+		void bakeArea(const map::Map& map, size_t layerId, int x0, int y0, int x1, int y1);
+
+		///
+		/// \brief scroll Moves rectangles columns to the left like TileData::scroll. Rectangles are cut at the left
+		/// edge, and emptied columns at the right edge have no rectangles.
+		/// \param columns	= Number of columns to scroll.
+		///
+		void scroll(size_t columns);
+
+		///
+		/// \brief forEachOverlapping Calls f(const Rect&) once for each rectangle overlapping tiles x0..x1, y0..y1.
+		/// Tiles outside of the map are solid: parts of the query outside of the map are given as
+		/// rectangles, which reach one tile beyond the query.
+		///
+		template<typename Func>
+		void forEachOverlapping(int x0, int y0, int x1, int y1, Func f) const {
+			const int sx = int(m_size.x);
+			const int sy = int(m_size.y);
+			for(int y = std::max(y0, 0); y <= std::min(y1, sy - 1); ++y) {
+				const auto* first = m_rowRects[size_t(y)].data();
+				const auto* last = first + m_rowRects[size_t(y)].size();
+				// Rectangles of a row don't overlap, so their ends are sorted too:
+				auto it = std::lower_bound(first, last, x0, [this](uint32_t id, int x) {
+					return m_rects[id].x + m_rects[id].width - 1 < x;
+				});
+				for(; it != last && m_rects[*it].x <= x1; ++it) {
+					const auto& r = m_rects[*it];
+					// Rectangle spanning many rows is given at its first row in the query:
+					if(y == std::max(y0, r.y)) {
+						f(r);
+					}
+				}
+			}
+			// Outside of the map:
+			if(x0 < 0) {
+				f(Rect{x0 - 1, y0 - 1, -x0 + 1, y1 - y0 + 3});
+			}
+			if(x1 >= sx) {
+				f(Rect{sx, y0 - 1, x1 - sx + 2, y1 - y0 + 3});
+			}
+			const int inX0 = std::max(x0, 0);
+			const int inX1 = std::min(x1, sx - 1);
+			if(inX0 <= inX1 && y0 < 0) {
+				f(Rect{inX0, y0 - 1, inX1 - inX0 + 1, -y0 + 1});
+			}
+			if(inX0 <= inX1 && y1 >= sy) {
+				f(Rect{inX0, sy, inX1 - inX0 + 1, y1 - sy + 2});
+			}
+		}
+
+		///
+		/// \brief getRects
+		/// \return Rectangles by id. Ids of removed rectangles are reused, meanwhile their rectangles are empty.
+		///
+		const std::vector<Rect>& getRects() const {
+			return m_rects;
+		}
+
+		const size2d_t& getSize() const {
+			return m_size;
+		}
+
+	private:
+		void add(Rect r);
+		void remove(uint32_t id);
+
+		size2d_t							m_size = {0,0};
+		std::vector<Rect>					m_rects;
+		std::vector<uint32_t>				m_freeIds;	// Ids of removed rectangles
+		std::vector<std::vector<uint32_t>>	m_rowRects;	// Rectangles covering each row sorted by x
+	};
+
+} // End - namespace rects
+} // End - namespace hungerland
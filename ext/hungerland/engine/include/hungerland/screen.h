@@ -77,6 +77,14 @@ namespace screen {
 		///
 		void drawSprite(const glm::mat4& transform, const texture::Texture& texture, const std::vector<shader::Constant>& constants={}, const std::string& surfaceShader="", const std::string& globals="");
 
+		///
+		/// \brief drawSprites Draws many sprites of same texture with one draw call. Quads of the sprites are
+		/// transformed on the CPU to a dynamic vertex buffer, which is reused over calls.
+		/// \param transforms
+		/// \param texture
+		///
+		void drawSprites(const std::vector<glm::mat4>& transforms, const texture::Texture& texture);
+
 		///
 		/// \brief drawScreenSizeQuad
 		/// \param texture
@@ -93,8 +101,12 @@ namespace screen {
 	private:
 		std::unique_ptr<graphics::FrameBuffer>	m_shadeFbo;
 		std::shared_ptr<shader::Shader>         m_ssqShader;
+		std::shared_ptr<shader::Shader>         m_batchShader;
 		std::shared_ptr<mesh::Mesh>				m_ssq;
 		std::shared_ptr<mesh::Mesh>				m_sprite;
+		std::shared_ptr<mesh::Mesh>				m_batch;			// Transformed quads of drawSprites
+		std::vector<glm::vec2>					m_batchPositions;
+		std::vector<glm::vec2>					m_batchTexCoords;
 
 	private:
 		// Copy not allowed
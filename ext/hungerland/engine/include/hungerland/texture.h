@@ -23,6 +23,7 @@
 =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
 #pragma once
 #include <hungerland/types.h>
+#include <cstdint>
 
 namespace hungerland {
 namespace texture {
@@ -38,9 +39,21 @@ namespace texture {
 		typedef std::shared_ptr<Texture> Ref;
 		Texture(unsigned width, unsigned height, unsigned nrChannels, const uint8_t* data);
 		Texture(unsigned width, unsigned height, unsigned nrChannels, const float* data);
+		///
+		/// \brief Texture Creates single channel unsigned integer texture (GL_R16UI), read with usampler2D.
+		///
+		Texture(unsigned width, unsigned height, const uint16_t* data);
 		Texture(unsigned width, unsigned height, bool isDepthTexture);
 		~Texture();
 
+		///
+		/// \brief update Replaces pixels of area of GL_R16UI texture.
+		/// \param x, y	= Top left pixel of the area.
+		/// \param width, height	= Size of the area.
+		/// \param data	= width*height pixels in row major order.
+		///
+		void update(unsigned x, unsigned y, unsigned width, unsigned height, const uint16_t* data);
+
 		void bind(unsigned textureIndex);
 		void setRepeat(bool repeat);
 		void setFiltering(bool filter);
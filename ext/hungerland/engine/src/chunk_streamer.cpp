@@ -0,0 +1,340 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#include <hungerland/chunk_streamer.h>
+#include <hungerland/texture.h>
+#include <hungerland/mesh.h>
+#include <algorithm>
+#include <cmath>
+
+namespace hungerland {
+namespace map {
+	namespace {
+		// Index of tileset having global tile id, or tilesets.size(). Neighbour tiles are likely
+		// from the same tileset, so tileset of the previous tile is checked first.
+		size_t findTileset(const std::vector<TilesetInfo>& tilesets, uint32_t id, size_t previous) {
+			auto contains = [&](size_t i) {
+				return id >= tilesets[i].firstGID && id < tilesets[i].firstGID + tilesets[i].tileCount;
+			};
+			if(previous < tilesets.size() && contains(previous)) {
+				return previous;
+			}
+			for(size_t i = 0; i < tilesets.size(); ++i) {
+				if(contains(i)) {
+					return i;
+				}
+			}
+			return tilesets.size();
+		}
+
+		// Lookup pixel of tile x,y: tileset relative tile id and flips performed on the shader.
+		// Returns 0 for empty tiles and tiles of unknown tilesets, otherwise sets tilesetId to the tileset of the tile.
+		uint16_t getPixel(const std::vector<TilesetInfo>& tilesets, const TileData& tiles, size_t x, size_t y, size_t& tilesetId) {
+			const auto tileId = uint32_t(tiles.getId(x, y));
+			if(tileId == 0) {
+				return 0;
+			}
+			const auto id = findTileset(tilesets, tileId, tilesetId);
+			if(id == tilesets.size()) {
+				return 0;
+			}
+			tilesetId = id;
+			const auto localId = tileId - tilesets[id].firstGID + 1;
+			const auto flips = uint32_t(tiles.getFlags(x, y) >> 1) << TileData::ID_BITS;
+			return uint16_t(localId | flips);
+		}
+	}
+
+	ChunkStreamer::ChunkStreamer(const std::vector< std::shared_ptr<TileLayer> >& layers, const std::vector<TilesetInfo>& tilesets,
+		const std::vector< std::shared_ptr<texture::Texture> >& tilesetTextures, const size2d_t& tileSize)
+		: m_layers(layers)
+		, m_tilesets(tilesets)
+		, m_tilesetTextures(tilesetTextures)
+		, m_tileSize(tileSize) {
+		assert(m_tilesets.size() == m_tilesetTextures.size());
+		m_thread = std::thread([this]() {
+			run();
+		});
+	}
+
+	ChunkStreamer::~ChunkStreamer() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_wakeUp.notify_one();
+		m_thread.join();
+	}
+
+	void ChunkStreamer::setTile(size_t layerIndex, size_t x, size_t y, int id, int flipFlags) {
+		uint64_t revision = 0;
+		{
+			std::lock_guard<std::mutex> lock(m_tilesMutex);
+			m_layers[layerIndex]->tiles.set(x, y, id, flipFlags);
+			revision = ++m_revision;
+		}
+		const auto key = getKey(layerIndex, int(x / CHUNK_SIZE), int(y / CHUNK_SIZE));
+		const auto tile = glm::ivec2(int(x % CHUNK_SIZE), int(y % CHUNK_SIZE));
+		// Chunks built before the edit are stale:
+		m_edited[key] = revision;
+		m_ready.erase(key);
+		auto dirty = m_dirty.find(key);
+		if(dirty == m_dirty.end()) {
+			m_dirty[key] = glm::ivec4(tile, tile);
+		} else {
+			dirty->second = glm::ivec4(glm::min(glm::ivec2(dirty->second), tile), glm::max(glm::ivec2(dirty->second.z, dirty->second.w), tile));
+		}
+	}
+
+	void ChunkStreamer::scroll(size_t columns) {
+		{
+			std::lock_guard<std::mutex> lock(m_tilesMutex);
+			for(auto& layer : m_layers) {
+				layer->tiles.scroll(columns);
+			}
+			m_scrolled = ++m_revision;
+		}
+		m_loaded.clear();
+		m_ready.clear();
+		m_dirty.clear();
+		m_edited.clear();
+	}
+
+	void ChunkStreamer::update(const glm::vec4& view) {
+		// Write edited tiles of loaded chunks. Other chunks read the tiles when they are built:
+		for(const auto& dirty : m_dirty) {
+			auto loaded = m_loaded.find(dirty.first);
+			if(loaded != m_loaded.end()) {
+				flush(dirty.first, loaded->second, dirty.second);
+			}
+		}
+		m_dirty.clear();
+
+		// Take chunks built by the background thread:
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for(auto& built : m_built) {
+				auto edited = m_edited.find(built.key);
+				const bool isStale = built.revision < m_scrolled || (edited != m_edited.end() && edited->second > built.revision);
+				if(false == isStale && m_loaded.count(built.key) == 0) {
+					const auto key = built.key;
+					m_ready[key] = std::move(built);
+				}
+			}
+			m_built.clear();
+			// Chunks built from now on read tiles after all edits so far. Only the chunk being built may still be stale:
+			for(auto it = m_edited.begin(); it != m_edited.end(); ) {
+				it = it->first == m_building ? std::next(it) : m_edited.erase(it);
+			}
+		}
+
+		std::vector<glm::ivec4> keepRanges;
+		std::vector< std::pair<int, uint64_t> > requests; // Distance from the view in chunks and chunk key
+		size_t numUploads = 0;
+		for(size_t layerIndex = 0; layerIndex < m_layers.size(); ++layerIndex) {
+			const auto visible = getRange(layerIndex, view, 0);
+			const auto prefetch = getRange(layerIndex, view, PREFETCH_CHUNKS);
+			keepRanges.push_back(getRange(layerIndex, view, KEEP_CHUNKS));
+			for(int cy = prefetch.y; cy <= prefetch.w; ++cy) {
+				for(int cx = prefetch.x; cx <= prefetch.z; ++cx) {
+					const auto key = getKey(layerIndex, cx, cy);
+					if(m_loaded.count(key) > 0) {
+						continue;
+					}
+					const bool isVisible = cx >= visible.x && cx <= visible.z && cy >= visible.y && cy <= visible.w;
+					auto ready = m_ready.find(key);
+					if(ready != m_ready.end() && (isVisible || numUploads < MAX_UPLOADS)) {
+						upload(ready->second);
+						m_ready.erase(ready);
+						++numUploads;
+					} else if(isVisible) {
+						// Background thread has not reached the chunk yet:
+						upload(build(key));
+					} else if(ready == m_ready.end()) {
+						const int dx = std::max(visible.x - cx, cx - visible.z);
+						const int dy = std::max(visible.y - cy, cy - visible.w);
+						requests.push_back({std::max(dx, dy), key});
+					}
+				}
+			}
+		}
+
+		// Evict chunks far from the view:
+		for(auto it = m_loaded.begin(); it != m_loaded.end(); ) {
+			it = isInRange(it->first, keepRanges) ? std::next(it) : m_loaded.erase(it);
+		}
+		for(auto it = m_ready.begin(); it != m_ready.end(); ) {
+			it = isInRange(it->first, keepRanges) ? std::next(it) : m_ready.erase(it);
+		}
+
+		// Replace requests of the background thread, nearest first:
+		std::stable_sort(requests.begin(), requests.end(), [](const auto& a, const auto& b) {
+			return a.first < b.first;
+		});
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_requests.clear();
+			for(const auto& request : requests) {
+				if(request.second != m_building) {
+					m_requests.push_back(request.second);
+				}
+			}
+		}
+		m_wakeUp.notify_one();
+	}
+
+	glm::ivec4 ChunkStreamer::getRange(size_t layerIndex, const glm::vec4& view, int margin) const {
+		const auto& layer = *m_layers[layerIndex];
+		const int numChunksX = int((layer.tiles.getWidth() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+		const int numChunksY = int((layer.tiles.getHeight() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+		const float chunkWidth = float(CHUNK_SIZE * m_tileSize.x);
+		const float chunkHeight = float(CHUNK_SIZE * m_tileSize.y);
+		const auto offset = glm::vec2(float(layer.info.offset.x), float(layer.info.offset.y));
+		// Clamp in float first, view may be far outside of the map:
+		auto toChunk = [](float v, float size, int numChunks) {
+			return int(std::floor(std::clamp(v / size, -1.0f, float(numChunks))));
+		};
+		const int left = toChunk(view.x - offset.x, chunkWidth, numChunksX) - margin;
+		const int top = toChunk(view.y - offset.y, chunkHeight, numChunksY) - margin;
+		const int right = toChunk(view.z - offset.x, chunkWidth, numChunksX) + margin;
+		const int bottom = toChunk(view.w - offset.y, chunkHeight, numChunksY) + margin;
+		return glm::ivec4(std::max(left, 0), std::max(top, 0), std::min(right, numChunksX - 1), std::min(bottom, numChunksY - 1));
+	}
+
+	bool ChunkStreamer::isInRange(uint64_t key, const std::vector<glm::ivec4>& ranges) const {
+		const auto chunk = getChunk(key);
+		const auto& range = ranges[size_t(chunk.z)];
+		return chunk.x >= range.x && chunk.x <= range.z && chunk.y >= range.y && chunk.y <= range.w;
+	}
+
+	ChunkStreamer::BuiltChunk ChunkStreamer::build(uint64_t key) {
+		std::lock_guard<std::mutex> lock(m_tilesMutex);
+		const auto chunk = getChunk(key);
+		const auto& tiles = m_layers[size_t(chunk.z)]->tiles;
+		const size_t x0 = size_t(chunk.x) * CHUNK_SIZE;
+		const size_t y0 = size_t(chunk.y) * CHUNK_SIZE;
+		const size_t width = std::min<size_t>(CHUNK_SIZE, tiles.getWidth() - x0);
+		const size_t height = std::min<size_t>(CHUNK_SIZE, tiles.getHeight() - y0);
+
+		// Fill lookup pixels of all used tilesets in one pass over the tiles.
+		// Pixels of tileset are allocated when first tile of the tileset is found.
+		BuiltChunk built;
+		built.key = key;
+		built.revision = m_revision;
+		std::vector<size_t> pixelsOfTileset(m_tilesets.size(), m_tilesets.size());
+		size_t tilesetId = 0;
+		for(size_t ly = 0; ly < height; ++ly) {
+			for(size_t lx = 0; lx < width; ++lx) {
+				const auto pixel = getPixel(m_tilesets, tiles, x0 + lx, y0 + ly, tilesetId);
+				if(pixel == 0) {
+					continue;
+				}
+				if(pixelsOfTileset[tilesetId] == m_tilesets.size()) {
+					pixelsOfTileset[tilesetId] = built.pixels.size();
+					built.tilesetIds.push_back(tilesetId);
+					built.pixels.push_back(std::vector<uint16_t>(width*height, 0));
+				}
+				built.pixels[pixelsOfTileset[tilesetId]][ly*width + lx] = pixel;
+			}
+		}
+		return built;
+	}
+
+	void ChunkStreamer::upload(const BuiltChunk& built) {
+		const auto chunk = getChunk(built.key);
+		const auto& layer = *m_layers[size_t(chunk.z)];
+		const size_t x0 = size_t(chunk.x) * CHUNK_SIZE;
+		const size_t y0 = size_t(chunk.y) * CHUNK_SIZE;
+		const size_t width = std::min<size_t>(CHUNK_SIZE, layer.tiles.getWidth() - x0);
+		const size_t height = std::min<size_t>(CHUNK_SIZE, layer.tiles.getHeight() - y0);
+		Chunk loaded;
+		loaded.tilesetIds = built.tilesetIds;
+		for(size_t i = 0; i < built.tilesetIds.size(); ++i) {
+			const auto& tileSet = m_tilesets[built.tilesetIds[i]];
+			TileSetSubset subset;
+			subset.used = true;
+			subset.opacity = layer.info.opacity;
+			subset.offset = layer.info.offset;
+			subset.tileMap = m_tilesetTextures[built.tilesetIds[i]];
+			subset.colorLookup = std::make_shared<texture::Texture>(unsigned(width), unsigned(height), &built.pixels[i][0]);
+			subset.tileSize = tileSet.tileSize;
+			subset.tilesetSize.x = tileSet.columns;
+			assert(tileSet.tileCount % tileSet.columns == 0);
+			subset.tilesetSize.y = tileSet.tileCount/tileSet.columns;
+			subset.mesh = quad::createImage(float(x0 * m_tileSize.x), float(y0 * m_tileSize.y), float(width * m_tileSize.x), float(height * m_tileSize.y));
+			loaded.subsets.push_back(subset);
+		}
+		m_loaded[built.key] = loaded;
+	}
+
+	void ChunkStreamer::flush(uint64_t key, Chunk& chunk, const glm::ivec4& area) {
+		const auto c = getChunk(key);
+		const auto& tiles = m_layers[size_t(c.z)]->tiles;
+		const size_t x0 = size_t(c.x) * CHUNK_SIZE + size_t(area.x);
+		const size_t y0 = size_t(c.y) * CHUNK_SIZE + size_t(area.y);
+		const size_t width = size_t(area.z - area.x + 1);
+		const size_t height = size_t(area.w - area.y + 1);
+		std::vector< std::vector<uint16_t> > pixels(chunk.tilesetIds.size(), std::vector<uint16_t>(width*height, 0));
+		size_t tilesetId = 0;
+		for(size_t ly = 0; ly < height; ++ly) {
+			for(size_t lx = 0; lx < width; ++lx) {
+				const auto pixel = getPixel(m_tilesets, tiles, x0 + lx, y0 + ly, tilesetId);
+				if(pixel == 0) {
+					continue;
+				}
+				const auto it = std::find(chunk.tilesetIds.begin(), chunk.tilesetIds.end(), tilesetId);
+				if(it == chunk.tilesetIds.end()) {
+					// Tileset not used by the chunk before the edit needs a new subset:
+					upload(build(key));
+					return;
+				}
+				pixels[size_t(it - chunk.tilesetIds.begin())][ly*width + lx] = pixel;
+			}
+		}
+		for(size_t i = 0; i < chunk.subsets.size(); ++i) {
+			chunk.subsets[i].colorLookup->update(unsigned(area.x), unsigned(area.y), unsigned(width), unsigned(height), &pixels[i][0]);
+		}
+	}
+
+	void ChunkStreamer::run() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while(true) {
+			m_wakeUp.wait(lock, [this]() {
+				return m_quit || false == m_requests.empty();
+			});
+			if(m_quit) {
+				return;
+			}
+			const auto key = m_requests.front();
+			m_requests.pop_front();
+			m_building = key;
+			lock.unlock();
+			auto built = build(key);
+			lock.lock();
+			m_built.push_back(std::move(built));
+			m_building = NOT_BUILDING;
+		}
+	}
+
+} // End - namespace map
+} // End - namespace hungerland
@@ -0,0 +1,291 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#include <hungerland/clearance.h>
+#include <hungerland/map.h>
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <limits>
+
+namespace hungerland {
+namespace clearance {
+
+	namespace {
+		// Fixed point signed distance of tile from squared distance in tiles. Quantized towards
+		// solid tiles, so that stored distances never overestimate clearance.
+		inline int16_t quantize(bool isSolid, float distanceSq) {
+			const float MAX_VALUE = float(std::numeric_limits<int16_t>::max());
+			const float d = isSolid ? -std::sqrt(distanceSq) : std::sqrt(distanceSq);
+			return int16_t(std::clamp(std::floor(d*Field::SCALE), -MAX_VALUE, MAX_VALUE));
+		}
+
+		// Largest absolute distance of a field.
+		inline int16_t maxDistance(const int16_t* distances, size_t n) {
+			int16_t res = 0;
+			for(size_t i=0; i<n; ++i) {
+				res = std::max<int16_t>(res, int16_t(std::abs(distances[i])));
+			}
+			return res;
+		}
+
+		// Squared distance from a tile center to a tile dx tiles away, along one axis.
+		inline float axisDistanceSq(int dx) {
+			const float d = std::max(0.0f, float(std::abs(dx)) - 0.5f);
+			return d*d;
+		}
+
+		///
+		/// \brief distanceTransform Squared euclidean distance from each tile center of columns x0..x1-1 to nearest
+		/// target tile. First pass finds nearest target of each row with two sweeps. Second pass combines rows: for
+		/// each tile, rows are searched outwards until row distance alone exceeds the best distance.
+		/// \param isTarget		= isTarget(x,y) -> bool tells target tiles.
+		/// \param borderIsTarget	= Tiles outside of the map are targets.
+		/// \param out				= Distances of the columns in row major order, (x1-x0)*sy elements.
+		///
+		template<typename IsTargetFunc>
+		void distanceTransform(IsTargetFunc isTarget, int sx, int sy, int x0, int x1, bool borderIsTarget, std::vector<float>& out) {
+			const int FAR = sx + sy + 2;
+			const int w = x1 - x0;
+			// Row pass: distance in tiles to nearest target in the same row. Sweeps start from nearest targets
+			// outside of the columns.
+			std::vector<int> rowDist(size_t(w)*sy);
+			for(int y=0; y<sy; ++y) {
+				int* row = &rowDist[size_t(y)*w];
+				int d = borderIsTarget ? x0 : FAR;
+				for(int x=x0; x-- > 0; ) {
+					if(isTarget(x, y)) {
+						d = x0 - 1 - x;
+						break;
+					}
+				}
+				for(int x=x0; x<x1; ++x) {
+					d = isTarget(x, y) ? 0 : std::min(d+1, FAR);
+					row[x-x0] = d;
+				}
+				d = borderIsTarget ? sx - x1 : FAR;
+				for(int x=x1; x<sx; ++x) {
+					if(isTarget(x, y)) {
+						d = x - x1;
+						break;
+					}
+				}
+				for(int x=x1; x-- > x0; ) {
+					d = isTarget(x, y) ? 0 : std::min(d+1, FAR);
+					row[x-x0] = std::min(row[x-x0], d);
+				}
+			}
+			// Column pass, row by row so that rows are read contiguously. Active columns are those,
+			// whose best distance may still improve from rows further away.
+			out.resize(size_t(w)*sy);
+			std::vector<int> active(w);
+			for(int y=0; y<sy; ++y) {
+				float* best = &out[size_t(y)*w];
+				const float border = borderIsTarget ? axisDistanceSq(std::min(y+1, sy-y)) : std::numeric_limits<float>::max();
+				std::fill(best, best+w, border);
+				for(int x=0; x<w; ++x) {
+					active[x] = x;
+				}
+				size_t numActive = size_t(w);
+				for(int dy=0; dy<sy && numActive > 0; ++dy) {
+					const float dyy = axisDistanceSq(dy);
+					size_t n = 0;
+					for(size_t i=0; i<numActive; ++i) {
+						const int x = active[i];
+						if(dyy >= best[x]) {
+							continue;
+						}
+						for(int ny : {y-dy, y+dy}) {
+							if(ny < 0 || ny >= sy) {
+								continue;
+							}
+							const int dx = rowDist[size_t(ny)*w + x];
+							if(dx < FAR) {
+								best[x] = std::min(best[x], dyy + axisDistanceSq(dx));
+							}
+						}
+						active[n++] = x;
+					}
+					numActive = n;
+				}
+			}
+		}
+	}
+
+	Field Field::bake(const map::Map& map, size_t layerId) {
+		Field res;
+		res.m_size = map.getMapSize();
+		const int sx = int(res.m_size.x);
+		const int sy = int(res.m_size.y);
+		std::vector<uint8_t> solid(size_t(sx)*sy);
+		for(int y=0; y<sy; ++y) {
+			for(int x=0; x<sx; ++x) {
+				solid[size_t(y)*sx + x] = map.getTileId(layerId, x, y) > 0 ? 1 : 0;
+			}
+		}
+		std::vector<float> toSolid, toFree;
+		distanceTransform([&](int x, int y) { return solid[size_t(y)*sx + x] != 0; }, sx, sy, 0, sx, true, toSolid);
+		distanceTransform([&](int x, int y) { return solid[size_t(y)*sx + x] == 0; }, sx, sy, 0, sx, false, toFree);
+		std::shared_ptr<int16_t> distances(new int16_t[solid.size()], std::default_delete<int16_t[]>());
+		for(size_t i=0; i<solid.size(); ++i) {
+			distances.get()[i] = quantize(solid[i] != 0, solid[i] ? toFree[i] : toSolid[i]);
+		}
+		res.m_distances = distances;
+		res.m_maxDistance = maxDistance(distances.get(), solid.size());
+		return res;
+	}
+
+	void Field::bakeColumns(const map::Map& map, size_t layerId, int x0, int x1) {
+		const int sx = int(m_size.x);
+		const int sy = int(m_size.y);
+		// Tiles further from the changed columns than the largest distance have their nearest tile elsewhere:
+		const int radius = getRadius();
+		x0 = std::max(x0 - radius, 0);
+		x1 = std::min(x1 + radius, sx);
+		if(x0 >= x1) {
+			return;
+		}
+		auto isSolid = [&](int x, int y) { return map.getTileId(layerId, x, y) > 0; };
+		std::vector<float> toSolid, toFree;
+		distanceTransform(isSolid, sx, sy, x0, x1, true, toSolid);
+		distanceTransform([&](int x, int y) { return false == isSolid(x, y); }, sx, sy, x0, x1, false, toFree);
+		const int w = x1 - x0;
+		for(int y=0; y<sy; ++y) {
+			int16_t* row = &m_distances.get()[size_t(y)*sx];
+			for(int x=x0; x<x1; ++x) {
+				const size_t i = size_t(y)*w + (x - x0);
+				row[x] = isSolid(x, y) ? quantize(true, toFree[i]) : quantize(false, toSolid[i]);
+				m_maxDistance = std::max<int16_t>(m_maxDistance, int16_t(std::abs(row[x])));
+			}
+		}
+	}
+
+	void Field::scroll(const map::Map& map, size_t layerId, size_t columns) {
+		columns = std::min(columns, size_t(m_size.x));
+		int16_t* distances = m_distances.get();
+		for(size_t y = 0; y < m_size.y; ++y) {
+			auto* row = distances + y*m_size.x;
+			std::copy(row + columns, row + m_size.x, row);
+		}
+		// Columns moved out of the map are solid now, and columns at the right edge are new:
+		bakeColumns(map, layerId, -int(columns), 0);
+		bakeColumns(map, layerId, int(m_size.x - columns), int(m_size.x));
+	}
+
+	Field Field::view(const size2d_t& size, std::shared_ptr<int16_t> distances) {
+		Field res;
+		res.m_size = size;
+		res.m_distances = distances;
+		res.m_maxDistance = maxDistance(distances.get(), size.x*size.y);
+		return res;
+	}
+
+	void Field::setSolid(size_t x, size_t y, bool solid) {
+		assert(x < m_size.x && y < m_size.y);
+		int16_t* distances = m_distances.get();
+		const size_t index = y*m_size.x + x;
+		if((distances[index] < 0) == solid) {
+			return;
+		}
+		const int sx = int(m_size.x);
+		const int sy = int(m_size.y);
+		// Only tiles further from the surface than from the changed tile get closer:
+		const int radius = getRadius();
+		// Distance to the changed tile is compared as squared distance in tiles. Tiles outside of
+		// the map are solid, so they are the other kind only for a free tile.
+		float nearestSq = solid ? std::numeric_limits<float>::max() : axisDistanceSq(std::min({int(x)+1, int(y)+1, sx-int(x), sy-int(y)}));
+		auto scan = [&](int r, bool update) {
+			for(int ty=std::max(0, int(y)-r); ty<std::min(sy, int(y)+r+1); ++ty) {
+				const float dyy = axisDistanceSq(ty - int(y));
+				int16_t* row = &distances[size_t(ty)*m_size.x];
+				for(int tx=std::max(0, int(x)-r); tx<std::min(sx, int(x)+r+1); ++tx) {
+					const bool isSolid = row[tx] < 0;
+					if(isSolid == solid || (tx == int(x) && ty == int(y))) {
+						continue;
+					}
+					// Tile of the other kind: nearest for the changed tile, and changed tile may be its nearest.
+					const float dSq = dyy + axisDistanceSq(tx - int(x));
+					nearestSq = std::min(nearestSq, dSq);
+					if(update) {
+						const auto d = quantize(isSolid, dSq);
+						row[tx] = isSolid ? std::max(row[tx], d) : std::min(row[tx], d);
+					}
+				}
+			}
+		};
+		scan(radius, true);
+		// Nearest tile of the other kind is known, when it is closer than any tile outside of the
+		// window. Otherwise search wider windows for it.
+		for(int r = radius; nearestSq > axisDistanceSq(r+1) && r < std::max(sx, sy); ) {
+			r *= 2;
+			scan(r, false);
+		}
+		distances[index] = quantize(solid, nearestSq);
+		m_maxDistance = std::max<int16_t>(m_maxDistance, int16_t(std::abs(distances[index])));
+	}
+
+	int Field::getRadius() const {
+		// No tile is further than m_maxDistance from the surface. Tile at dx,dy is at least
+		// max(|dx|,|dy|)-0.5 tiles away, so tiles outside of the radius are further.
+		return int(std::ceil(float(m_maxDistance)/SCALE + 0.5f));
+	}
+
+	float Field::getDistance(int x, int y) const {
+		if(x < 0 || y < 0 || size_t(x) >= m_size.x || size_t(y) >= m_size.y) {
+			return -0.5f;
+		}
+		return float(m_distances.get()[y*m_size.x + x]) * (1.0f/SCALE);
+	}
+
+	float Field::sample(float x, float y) const {
+		// Tile centers are at integer coordinates.
+		const float fx = std::floor(x), fy = std::floor(y);
+		const int x0 = int(fx), y0 = int(fy);
+		const float tx = x - fx, ty = y - fy;
+		const float d00 = getDistance(x0, y0), d10 = getDistance(x0+1, y0);
+		const float d01 = getDistance(x0, y0+1), d11 = getDistance(x0+1, y0+1);
+		return (d00*(1.0f-tx) + d10*tx)*(1.0f-ty) + (d01*(1.0f-tx) + d11*tx)*ty;
+	}
+
+	glm::vec2 Field::getGradient(float x, float y) const {
+		const float H = 0.5f;
+		const glm::vec2 g((sample(x+H, y) - sample(x-H, y)) / (2.0f*H), (sample(x, y+H) - sample(x, y-H)) / (2.0f*H));
+		const float len = glm::length(g);
+		return len > 1e-6f ? g / len : glm::vec2(0);
+	}
+
+	float Field::getClearance(float x, float y) const {
+		// Distance changes at most by the distance moved, so each tile center c gives lower bound
+		// d(c) - |p-c|. Bilinear weighted sum of the bounds is a lower bound as well.
+		const float fx = std::floor(x), fy = std::floor(y);
+		const int x0 = int(fx), y0 = int(fy);
+		const float tx = x - fx, ty = y - fy;
+		auto bound = [&](int dx, int dy) {
+			return getDistance(x0+dx, y0+dy) - std::sqrt((tx-dx)*(tx-dx) + (ty-dy)*(ty-dy));
+		};
+		const float d = (bound(0,0)*(1.0f-tx) + bound(1,0)*tx)*(1.0f-ty) + (bound(0,1)*(1.0f-tx) + bound(1,1)*tx)*ty;
+		return std::max(0.0f, d);
+	}
+
+} // End - namespace clearance
+} // End - namespace hungerland
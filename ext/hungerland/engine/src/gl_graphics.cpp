@@ -228,14 +228,17 @@ namespace hungerland {
 				"uniform vec2 tileSize;\n"
 				"uniform vec2 tilesetSize ;\n"
 				"uniform float opacity;\n"
-				"uniform sampler2D lookupMap;\n"
+				"uniform usampler2D lookupMap;\n"
 				"uniform sampler2D tileMap;\n"
 				"out vec4 FragColor;\n"
 				"void main() {\n"
-				"	vec4 values = texture(lookupMap, texCoord);\n"
-				"	if(values.r > 0.0) {\n"
-				"		vec2 position = getTilePosition(values.r, tilesetSize);\n"
-				"		vec2 offset = getTileOffset(values.g, texCoord, textureSize(lookupMap, 0), tileSize, tilesetSize);\n"
+				// Lookup texel: tileset relative tile index in low 13 bits and tile flips in high 3 bits
+				"	ivec2 lookupSize = textureSize(lookupMap, 0);\n"
+				"	uint value = texelFetch(lookupMap, clamp(ivec2(texCoord * vec2(lookupSize)), ivec2(0), lookupSize - 1), 0).r;\n"
+				"	uint tileIndex = value & 0x1fffu;\n"
+				"	if(tileIndex > 0u) {\n"
+				"		vec2 position = getTilePosition(float(tileIndex), tilesetSize);\n"
+				"		vec2 offset = getTileOffset(float((value >> 13u) << 1u), texCoord, vec2(lookupSize), tileSize, tilesetSize);\n"
 				"       vec4 color = texture(tileMap, position + offset);\n"
 				"		color.a = min(opacity, color.a);\n"
 				"		FragColor = color;\n"
@@ -93,6 +93,46 @@ namespace screen {
 		});
 	}
 
+	void Screen::drawSprites(const std::vector<glm::mat4>& transforms, const texture::Texture& texture) {
+		if(transforms.empty()) {
+			return;
+		}
+		// Corners of the sprite quad, as in quad::createSprite:
+		static const glm::vec2 POSITIONS[6] = {{0.5f,-0.5f}, {0.5f,0.5f}, {-0.5f,0.5f}, {0.5f,-0.5f}, {-0.5f,0.5f}, {-0.5f,-0.5f}};
+		static const glm::vec2 TEXTURE_COORDS[6] = {{1,0}, {1,1}, {0,1}, {1,0}, {0,1}, {0,0}};
+		// Quads are transformed here, so that all sprites are drawn with one draw call from one dynamic buffer:
+		m_batchPositions.clear();
+		for(const auto& matModel : transforms) {
+			for(const auto& p : POSITIONS) {
+				m_batchPositions.push_back(glm::vec2(matModel * glm::vec4(p, 0.0f, 1.0f)));
+			}
+		}
+		const bool isGrown = m_batchTexCoords.size() < m_batchPositions.size();
+		while(m_batchTexCoords.size() < m_batchPositions.size()) {
+			m_batchTexCoords.insert(m_batchTexCoords.end(), TEXTURE_COORDS, TEXTURE_COORDS + 6);
+		}
+		if(!m_batchShader) {
+			m_batchShader = shaders::createSprite({}, "", "");
+		}
+		if(!m_batch) {
+			m_batch = mesh::create(m_batchPositions, m_batchTexCoords);
+		} else {
+			m_batch->setVBOData(0, m_batchPositions, true);
+			if(isGrown) {
+				m_batch->setVBOData(1, m_batchTexCoords, true);
+			}
+		}
+		const glm::mat4 identity(1.0f);
+		m_batchShader->use([&](shader::ShaderPass shader) {
+			shader.setUniformm("P", &m_projection[0][0]);
+			shader.setUniformm("M", &identity[0][0]);
+			shader.setUniform("texture0", 0);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, texture.getId());
+			mesh::draw(*m_batch, GL_TRIANGLES, unsigned(m_batchPositions.size()));
+		});
+	}
+
 	void Screen::drawScreenSizeQuad(const texture::Texture& texture) {
 		m_ssqShader->use([&](shader::ShaderPass shader) {
 			shader.setUniformm("P", &m_projection[0][0]);
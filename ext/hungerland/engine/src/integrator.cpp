@@ -0,0 +1,124 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#include <hungerland/integrator.h>
+#include <assert.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define HUNGERLAND_INTEGRATOR_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HUNGERLAND_INTEGRATOR_SSE
+#endif
+
+namespace hungerland {
+namespace integrator {
+
+	void integrateScalar(Bodies& bodies, const Params& params, float dt, size_t begin, size_t end) {
+		for(auto i = begin; i < end; ++i) {
+			float vx = bodies.vx[i] + (bodies.fx[i] + params.gravity.x - params.drag * bodies.vx[i]) * dt;
+			float vy = bodies.vy[i] + (bodies.fy[i] + params.gravity.y - params.drag * bodies.vy[i]) * dt;
+			float px = bodies.px[i] + vx * dt;
+			float py = bodies.py[i] + vy * dt;
+			// Clamp to bounds:
+			const float cx = glm::clamp(px, params.boundsMin.x, params.boundsMax.x);
+			const float cy = glm::clamp(py, params.boundsMin.y, params.boundsMax.y);
+			if(cx != px) vx = 0.0f;
+			if(cy != py) vy = 0.0f;
+			bodies.px[i] = cx;
+			bodies.py[i] = cy;
+			bodies.vx[i] = vx;
+			bodies.vy[i] = vy;
+		}
+	}
+
+	void integrate(Bodies& bodies, const Params& params, float dt) {
+		const auto n = bodies.size();
+		assert(bodies.py.size() == n && bodies.vx.size() == n && bodies.vy.size() == n);
+		assert(bodies.fx.size() == n && bodies.fy.size() == n);
+		size_t i = 0;
+#if defined(HUNGERLAND_INTEGRATOR_AVX)
+		const auto vdt		= _mm256_set1_ps(dt);
+		const auto vdrag	= _mm256_set1_ps(params.drag);
+		const auto vgx		= _mm256_set1_ps(params.gravity.x);
+		const auto vgy		= _mm256_set1_ps(params.gravity.y);
+		const auto vminX	= _mm256_set1_ps(params.boundsMin.x);
+		const auto vminY	= _mm256_set1_ps(params.boundsMin.y);
+		const auto vmaxX	= _mm256_set1_ps(params.boundsMax.x);
+		const auto vmaxY	= _mm256_set1_ps(params.boundsMax.y);
+		for(; i + 8 <= n; i += 8) {
+			auto vx = _mm256_loadu_ps(&bodies.vx[i]);
+			auto vy = _mm256_loadu_ps(&bodies.vy[i]);
+			const auto ax = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(&bodies.fx[i]), vgx), _mm256_mul_ps(vdrag, vx));
+			const auto ay = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(&bodies.fy[i]), vgy), _mm256_mul_ps(vdrag, vy));
+			vx = _mm256_add_ps(vx, _mm256_mul_ps(ax, vdt));
+			vy = _mm256_add_ps(vy, _mm256_mul_ps(ay, vdt));
+			const auto px = _mm256_add_ps(_mm256_loadu_ps(&bodies.px[i]), _mm256_mul_ps(vx, vdt));
+			const auto py = _mm256_add_ps(_mm256_loadu_ps(&bodies.py[i]), _mm256_mul_ps(vy, vdt));
+			const auto cx = _mm256_min_ps(_mm256_max_ps(px, vminX), vmaxX);
+			const auto cy = _mm256_min_ps(_mm256_max_ps(py, vminY), vmaxY);
+			// Zero velocity of clamped components:
+			vx = _mm256_and_ps(vx, _mm256_cmp_ps(cx, px, _CMP_EQ_OQ));
+			vy = _mm256_and_ps(vy, _mm256_cmp_ps(cy, py, _CMP_EQ_OQ));
+			_mm256_storeu_ps(&bodies.px[i], cx);
+			_mm256_storeu_ps(&bodies.py[i], cy);
+			_mm256_storeu_ps(&bodies.vx[i], vx);
+			_mm256_storeu_ps(&bodies.vy[i], vy);
+		}
+#elif defined(HUNGERLAND_INTEGRATOR_SSE)
+		const auto vdt		= _mm_set1_ps(dt);
+		const auto vdrag	= _mm_set1_ps(params.drag);
+		const auto vgx		= _mm_set1_ps(params.gravity.x);
+		const auto vgy		= _mm_set1_ps(params.gravity.y);
+		const auto vminX	= _mm_set1_ps(params.boundsMin.x);
+		const auto vminY	= _mm_set1_ps(params.boundsMin.y);
+		const auto vmaxX	= _mm_set1_ps(params.boundsMax.x);
+		const auto vmaxY	= _mm_set1_ps(params.boundsMax.y);
+		for(; i + 4 <= n; i += 4) {
+			auto vx = _mm_loadu_ps(&bodies.vx[i]);
+			auto vy = _mm_loadu_ps(&bodies.vy[i]);
+			const auto ax = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(&bodies.fx[i]), vgx), _mm_mul_ps(vdrag, vx));
+			const auto ay = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(&bodies.fy[i]), vgy), _mm_mul_ps(vdrag, vy));
+			vx = _mm_add_ps(vx, _mm_mul_ps(ax, vdt));
+			vy = _mm_add_ps(vy, _mm_mul_ps(ay, vdt));
+			const auto px = _mm_add_ps(_mm_loadu_ps(&bodies.px[i]), _mm_mul_ps(vx, vdt));
+			const auto py = _mm_add_ps(_mm_loadu_ps(&bodies.py[i]), _mm_mul_ps(vy, vdt));
+			const auto cx = _mm_min_ps(_mm_max_ps(px, vminX), vmaxX);
+			const auto cy = _mm_min_ps(_mm_max_ps(py, vminY), vmaxY);
+			// Zero velocity of clamped components:
+			vx = _mm_and_ps(vx, _mm_cmpeq_ps(cx, px));
+			vy = _mm_and_ps(vy, _mm_cmpeq_ps(cy, py));
+			_mm_storeu_ps(&bodies.px[i], cx);
+			_mm_storeu_ps(&bodies.py[i], cy);
+			_mm_storeu_ps(&bodies.vx[i], vx);
+			_mm_storeu_ps(&bodies.vy[i], vy);
+		}
+#endif
+		// Rest of bodies (or all without SIMD):
+		integrateScalar(bodies, params, dt, i, n);
+	}
+
+} // End - namespace integrator
+
+} // End - namespace hungerland
@@ -0,0 +1,194 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#include <hungerland/jobs.h>
+
+namespace hungerland {
+namespace jobs {
+
+	namespace {
+		// Job system and queue index of the current worker thread.
+		thread_local const JobSystem*	t_system = 0;
+		thread_local size_t				t_queueIndex = 0;
+	}
+
+	bool Counter::isDone() const {
+		// Lock makes sure that the finishing job has released the counter before it can be destroyed by the waiter.
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_value == 0;
+	}
+
+	JobSystem::JobSystem(size_t numWorkers) {
+		if(numWorkers == 0) {
+			const auto numThreads = std::thread::hardware_concurrency();
+			numWorkers = numThreads > 1 ? numThreads - 1 : 0;
+		}
+		for(size_t i = 0; i < numWorkers; ++i) {
+			m_queues.push_back(std::make_unique<Queue>());
+		}
+		for(size_t i = 0; i < numWorkers; ++i) {
+			m_workers.push_back(std::thread([this, i]() {
+				workerMain(i);
+			}));
+		}
+	}
+
+	JobSystem::~JobSystem() {
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_quit = true;
+		}
+		m_sleepCondition.notify_all();
+		for(auto& worker : m_workers) {
+			worker.join();
+		}
+	}
+
+	size_t JobSystem::getNumWorkers() const {
+		return m_workers.size();
+	}
+
+	void JobSystem::run(JobFunc job, Counter* counter) {
+		if(counter) {
+			++counter->m_value;
+		}
+		push(Job{job, counter});
+	}
+
+	void JobSystem::runAfter(Counter& dependency, JobFunc job, Counter* counter) {
+		if(counter) {
+			++counter->m_value;
+		}
+		{
+			std::lock_guard<std::mutex> lock(dependency.m_mutex);
+			if(dependency.m_value > 0) {
+				dependency.m_continuations.push_back({job, counter});
+				return;
+			}
+		}
+		push(Job{job, counter});
+	}
+
+	void JobSystem::wait(Counter& counter) {
+		const auto queueIndex = (t_system == this) ? t_queueIndex : 0;
+		while(false == counter.isDone()) {
+			if(false == tryExecute(queueIndex)) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::push(Job job) {
+		if(m_queues.empty()) {
+			// No workers, run on calling thread:
+			execute(job);
+			return;
+		}
+		const auto queueIndex = (t_system == this) ? t_queueIndex : (m_nextQueue++ % m_queues.size());
+		++m_numQueued;
+		{
+			auto& queue = *m_queues[queueIndex];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back(std::move(job));
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_sleepCondition.notify_one();
+	}
+
+	bool JobSystem::pop(size_t queueIndex, Job& job) {
+		auto& queue = *m_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if(queue.jobs.empty()) {
+			return false;
+		}
+		job = std::move(queue.jobs.back());
+		queue.jobs.pop_back();
+		return true;
+	}
+
+	bool JobSystem::steal(size_t queueIndex, Job& job) {
+		for(size_t i = 1; i < m_queues.size(); ++i) {
+			auto& queue = *m_queues[(queueIndex + i) % m_queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if(false == queue.jobs.empty()) {
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool JobSystem::tryExecute(size_t queueIndex) {
+		if(m_queues.empty()) {
+			return false;
+		}
+		Job job;
+		if(pop(queueIndex, job) || steal(queueIndex, job)) {
+			--m_numQueued;
+			execute(job);
+			return true;
+		}
+		return false;
+	}
+
+	void JobSystem::execute(Job& job) {
+		job.func();
+		if(job.counter) {
+			finish(*job.counter);
+		}
+	}
+
+	void JobSystem::finish(Counter& counter) {
+		std::vector<Counter::Continuation> continuations;
+		{
+			std::lock_guard<std::mutex> lock(counter.m_mutex);
+			if(--counter.m_value == 0) {
+				continuations.swap(counter.m_continuations);
+			}
+		}
+		// Counter may be destroyed from now on, start jobs waiting for it:
+		for(auto& c : continuations) {
+			push(Job{c.func, c.counter});
+		}
+	}
+
+	void JobSystem::workerMain(size_t workerIndex) {
+		t_system = this;
+		t_queueIndex = workerIndex;
+		while(false == m_quit) {
+			if(tryExecute(workerIndex)) {
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_sleepCondition.wait(lock, [this]() {
+				return m_quit || m_numQueued > 0;
+			});
+		}
+	}
+
+} // End - namespace jobs
+
+} // End - namespace hungerland
@@ -22,230 +22,676 @@
  SOFTWARE.
 =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
 #include <hungerland/map.h>
+#include <hungerland/chunk_streamer.h>
 #include <hungerland/shader.h>
 #include <hungerland/texture.h>
 #include <hungerland/mesh.h>
 #include <hungerland/util.h>
 #include <hungerland/gl_utils.h>
 #include <hungerland/graphics.h>
+#include <hungerland/jobs.h>
+#include <hungerland/window.h>
 #include <glad/gl.h>
 
-#include <tmxlite/Map.hpp>
-#include <tmxlite/TileLayer.hpp>
+#include <hungerland/mapped_file.h>
 #include <tmxlite/Map.hpp>
 #include <tmxlite/TileLayer.hpp>
 #include <tmxlite/ImageLayer.hpp>
+#include <tmxlite/ObjectGroup.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HUNGERLAND_MAP_SSE
+#endif
 
 namespace hungerland {
 namespace map {
-	/// TileLayer
-	TileLayer::TileLayer(const tmx::Map& map, size_t layerIndex, const std::vector<std::shared_ptr<texture::Texture> >& tilesetTextures) {
-		const tmx::TileLayer& layer = *dynamic_cast<tmx::TileLayer*>(map.getLayers()[layerIndex].get());
-		util::INFO("Creating map layer: index="+std::to_string(layerIndex)+", type=TileLayer, Name=\"" + layer.getName() + "\"");
-		const auto& layerSize =  layer.getSize();
-		const auto& layerTiles = layer.getTiles();
-		const auto& tilesets = map.getTilesets();
-		tileIds = util::gridNM(layer.getSize().x,layer.getSize().y, 0);
-		tileFlags = util::gridNM(layer.getSize().x,layer.getSize().y, 0);
-		// Create objects from non zero tile ids:
-		for(auto ly = 0u; ly < layerSize.y; ++ly) {
-			for(auto lx = 0u; lx < layerSize.x; ++lx) {
-				auto tileIndex = ly * layerSize.x + lx;
-				auto layerTile = layerTiles[tileIndex];
-				if(layerTile.ID > 0) {
-					//tileIds[layerSize.y-ly-1][lx] = layerTile.ID;
-					//tileFlags[tileIds.size()-ly-1][lx] = layerTile.flipFlags;
-					//objects.push_back({lx,layerSize.y-ly-1});
-					tileIds[ly][lx] = layerTile.ID;
-					tileFlags[ly][lx] = layerTile.flipFlags;
-					objects.push_back({lx,ly});
-				}
-			}
-		}
-		/*util::INFO("Layer index=" + std::to_string(layerIndex) + " has " + std::to_string(objects.size()) + " objects");
-		for(const auto& o : objects){
-			util::INFO("x=" + std::to_string(o.x) + "y=" + std::to_string(o.y));
-		}*/
-
-		std::vector<float> layerPixels;
-		bool tsUsed = false;
-		for(auto tilesetId = 0u; tilesetId < tilesets.size(); ++tilesetId) {
-			// Check each tile ID to see if it falls in the current tile set
-			const auto& tileSet = tilesets[tilesetId];
-			const auto& layerTiles = layer.getTiles();
-			std::vector<float> layerPixels;
-			bool tsUsed = false;
-			for(auto ly = 0u; ly < layerSize.y; ++ly) {
-				for(auto lx = 0u; lx < layerSize.x; ++lx) {
-					auto tileIndex = ly * layerSize.x + lx;
-					auto layerTileID = layerTiles[tileIndex].ID;
-					auto firstGID = tileSet.getFirstGID();
-					auto lastGID = firstGID + tileSet.getTileCount() - 1;
-					if(layerTileID >= firstGID && layerTileID <= lastGID) {
-						auto tileId = layerTileID - firstGID + 1;
-						// Red channel: making sure to index relative to the tileset
-						layerPixels.push_back(float(tileId));
-						// Green channel: tile flips are performed on the shader
-						layerPixels.push_back(float(layerTiles[tileIndex].flipFlags));
-						layerPixels.push_back(0);
-						layerPixels.push_back(0);
-						tsUsed = true;
-					} else {
-						// Pad with empty space
-						layerPixels.push_back(0);
-						layerPixels.push_back(0);
-						layerPixels.push_back(0);
-						layerPixels.push_back(0);
-					}
-				}
-			}
+	namespace {
+		// Cooked map file layout. All sections start at 8 byte aligned offsets, so data can be
+		// used in place from the memory mapped file. Multi byte values are in native byte order,
+		// which is checked with COOKED_ENDIAN.
+		const char COOKED_MAGIC[8] = {'H','L','M','A','P','C','K','\0'};
+		const uint32_t COOKED_ENDIAN = 0x01020304;
 
-			//if we have some data for this tile set, create the resources
-			if(tsUsed) {
-				auto bounds = map.getBounds();
-				assert(tilesetId < tilesetTextures.size());
-				TileSetSubset subset;
-				subset.used = true;
-				subset.opacity = layer.getOpacity();
-				subset.offset.x = layer.getOffset().x;
-				subset.offset.y = layer.getOffset().y;
-				subset.tileMap = tilesetTextures[tilesetId];
-				subset.colorLookup = std::make_shared<texture::Texture>(layerSize.x, layerSize.y, 4, &layerPixels[0]);
-				subset.tileSize.x =  tileSet.getTileSize().x;
-				subset.tileSize.y = tileSet.getTileSize().y;
-				subset.tilesetSize.x = tileSet.getColumnCount();
-				assert(tileSet.getTileCount() % tileSet.getColumnCount() == 0);
-				subset.tilesetSize.y = tileSet.getTileCount()/tileSet.getColumnCount();
-
-				subset.mesh = quad::createImage(bounds.left, bounds.top, bounds.width, bounds.height);
-				subsets.push_back(subset);
-			} else {
-				subsets.push_back(TileSetSubset()); // Un used subset
-			}
-		}
-	}
+		struct CookedString {
+			uint32_t	offset;		// Offset in string table
+			uint32_t	length;
+		};
+
+		struct CookedHeader {
+			char		magic[8];
+			uint32_t	version;
+			uint32_t	endian;
+			uint32_t	mapSize[2];
+			uint32_t	tileSize[2];
+			float		clearColor[4];
+			float		bounds[4];
+			uint32_t	numTilesets;
+			uint32_t	numLayers;
+			uint32_t	numSurfaces;
+			uint32_t	stringsSize;
+			uint32_t	numObjects;
+			uint32_t	padding;
+			uint64_t	tilesetsOffset;		// numTilesets CookedTileset
+			uint64_t	layersOffset;		// numLayers CookedLayer
+			uint64_t	surfacesOffset;		// numSurfaces Map::Surface
+			uint64_t	objectsOffset;		// numObjects CookedObject
+			uint64_t	stringsOffset;		// stringsSize chars
+			uint64_t	fileSize;
+		};
+
+		struct CookedTileset {
+			CookedString	imagePath;
+			uint32_t		firstGID;
+			uint32_t		tileCount;
+			uint32_t		columns;
+			uint32_t		tileSize[2];
+			uint32_t		padding;
+		};
+
+		struct CookedLayer {
+			CookedString	name;
+			uint32_t		type;
+			float			opacity;
+			int32_t			offset[2];
+			CookedString	imagePath;
+			uint32_t		repeat[2];
+			float			parallaxFactor[2];
+			uint32_t		hasTransparency;
+			float			transparentColor[4];
+			uint32_t		padding;
+			uint64_t		tilesOffset;		// mapSize.x*mapSize.y packed tiles (uint16_t), tile layers only
+			uint64_t		distancesOffset;	// mapSize.x*mapSize.y distances (int16_t), tile layers only
+		};
+
+		struct CookedObject {
+			CookedString	name;
+			CookedString	type;
+			CookedString	layer;
+			float			bounds[4];
+			uint32_t		id;
+			uint32_t		padding;
+		};
 
+		static_assert(sizeof(CookedHeader) % 8 == 0 && sizeof(CookedTileset) % 8 == 0 && sizeof(CookedLayer) % 8 == 0
+			&& sizeof(CookedObject) % 8 == 0, "Cooked records must keep 8 byte alignment");
+		static_assert(sizeof(Map::Surface) == 3*sizeof(float), "Surfaces are stored as they are in memory");
+	}
 
 	/// ImageLayer
-	ImageLayer::ImageLayer(const tmx::Map& map, size_t layerIndex, const std::vector< std::shared_ptr<texture::Texture> >& imageTextures) {
-		const tmx::ImageLayer& layer = *dynamic_cast<tmx::ImageLayer*>(map.getLayers()[layerIndex].get());
-		util::INFO("Creating map layer: index="+std::to_string(layerIndex)+", type=ImageLayer, Name=\"" + layer.getName() + "\"");
+	ImageLayer::ImageLayer(const LayerInfo& info, std::shared_ptr<texture::Texture> texture, const glm::vec4& bounds) {
 		subset.used = true;
-		subset.opacity = layer.getOpacity();
-		subset.texture = imageTextures[layerIndex];
-		subset.offset.x = layer.getOffset().x;
-		subset.offset.y = layer.getOffset().y;
-		subset.repeat.x = layer.getRepeat().x;
-		subset.repeat.y = layer.getRepeat().y;
-		subset.parallaxFactor.x = layer.getParallax().x;
-		subset.parallaxFactor.y = layer.getParallax().y;
-		if(layer.hasTransparency()) {
-			subset.transparentColor.push_back(layer.getTransparencyColour().r);
-			subset.transparentColor.push_back(layer.getTransparencyColour().g);
-			subset.transparentColor.push_back(layer.getTransparencyColour().b);
-			subset.transparentColor.push_back(layer.getTransparencyColour().a);
+		subset.opacity = info.opacity;
+		subset.texture = texture;
+		subset.offset = info.offset;
+		subset.repeat = info.repeat;
+		subset.parallaxFactor = info.parallaxFactor;
+		if(info.hasTransparency) {
+			subset.transparentColor.push_back(info.transparentColor.r);
+			subset.transparentColor.push_back(info.transparentColor.g);
+			subset.transparentColor.push_back(info.transparentColor.b);
+			subset.transparentColor.push_back(info.transparentColor.a);
 		}
 		// Create mesh
-		auto texture = imageTextures[layerIndex];
-		auto bounds = map.getBounds();
-		float texScaleX = float(bounds.width)/float(subset.texture->getWidth());
-		float texScaleY = float(bounds.height)/float(subset.texture->getHeight());
-		subset.mesh = quad::createImage(bounds.left, bounds.top, bounds.width, bounds.height, texScaleX, texScaleY);
+		float texScaleX = bounds.z/float(subset.texture->getWidth());
+		float texScaleY = bounds.w/float(subset.texture->getHeight());
+		subset.mesh = quad::createImage(bounds.x, bounds.y, bounds.z, bounds.w, texScaleX, texScaleY);
+	}
+
+	std::shared_ptr<DecodedImage> decodeImage(const std::string& fileName) {
+		window::Image image(fileName);
+		if(image.data == 0) {
+			return 0;
+		}
+		auto res = std::make_shared<DecodedImage>();
+		res->width = unsigned(image.size.x);
+		res->height = unsigned(image.size.y);
+		res->channels = unsigned(image.bpp);
+		res->pixels.assign(image.data, image.data + size_t(res->width)*res->height*res->channels);
+		return res;
 	}
 
 	/// Map
 	Map::Map(const std::string& mapFilename, LoadTextureFuncType loadTexture)
-		: m_clearColor(0.5,0.5,0.5,1)
-		, m_map(std::make_shared<tmx::Map>())
-		, m_tileLayerShader(shaders::createTileLayer())
-		, m_imageLayerShader(shaders::createImageLayer())	{
+		: Map(mapFilename, DecodeImageFuncType(), loadTexture ? CreateTextureFuncType([loadTexture](const std::string& fileName, const DecodedImage&) {
+			return loadTexture(fileName);
+		}) : CreateTextureFuncType()) {
+	}
+
+	Map::Map(const std::string& mapFilename, DecodeImageFuncType decodeImage, CreateTextureFuncType createTexture, jobs::JobSystem* jobSystem)
+		: m_tileLayerShader(createTexture ? shaders::createTileLayer() : 0)
+		, m_imageLayerShader(createTexture ? shaders::createImageLayer() : 0)
+		, m_clearColor(0.5,0.5,0.5,1) {
 		// Load map
-		if(false == m_map->load(mapFilename)) {
+		std::vector<TileData> layerTiles;
+		if(std::filesystem::path(mapFilename).extension() == COOKED_EXTENSION) {
+			loadCooked(mapFilename, layerTiles);
+		} else {
+			loadTmx(mapFilename, layerTiles);
+		}
+		const bool hasGraphics = bool(createTexture);
+
+		// Tile layers are created first, jobs bake their distance fields:
+		for(auto i = 0u; i < m_layerInfos.size(); ++i) {
+			const auto& info = m_layerInfos[i];
+			m_layerNames[info.name] = i;
+			if(info.type == LayerInfo::TILE) {
+				util::INFO("Creating map layer: index="+std::to_string(i)+", type=TileLayer, Name=\"" + info.name + "\"");
+				assert(m_allLayersMap[i][0] == 0 && m_allLayersMap[i][1] == m_tileLayers.size());
+				m_tileLayers.push_back(std::make_shared<TileLayer>(layerTiles[m_tileLayers.size()], info));
+				m_layerTiles.push_back(m_tileLayers.back()->tiles);
+			}
+		}
+
+		// Image files of tilesets and image layers. Each file is decoded once:
+		std::vector<std::string> imageFiles;
+		auto addImageFile = [&imageFiles](const std::string& fileName) {
+			if(std::find(imageFiles.begin(), imageFiles.end(), fileName) == imageFiles.end()) {
+				imageFiles.push_back(fileName);
+			}
+		};
+		for(const auto& ts : m_tilesets) {
+			if(hasGraphics) {
+				addImageFile(ts.imagePath);
+			}
+		}
+		for(const auto& info : m_layerInfos) {
+			if(hasGraphics && info.type == LayerInfo::IMAGE && info.imagePath.size() > 0) {
+				addImageFile(info.imagePath);
+			}
+		}
+
+		// Decode images and bake distance fields and collision rectangles in parallel. Each job writes only its own element.
+		std::unique_ptr<jobs::JobSystem> loadingJobs;
+		if(jobSystem == 0) {
+			loadingJobs = std::make_unique<jobs::JobSystem>();
+			jobSystem = loadingJobs.get();
+		}
+		jobs::Counter counter;
+		std::vector< std::shared_ptr<DecodedImage> > images(imageFiles.size());
+		for(size_t i = 0; i < imageFiles.size() && decodeImage; ++i) {
+			jobSystem->run([&images, &imageFiles, &decodeImage, i]() {
+				images[i] = decodeImage(imageFiles[i]);
+			}, &counter);
+		}
+		// Collision rectangles are baked always, distance fields unless loaded from cooked map:
+		m_collisionRects.resize(m_tileLayers.size());
+		for(auto i = 0u; i < m_allLayersMap.size(); ++i) {
+			if(m_allLayersMap[i][0] == 0) {
+				jobSystem->run([this, i]() {
+					m_collisionRects[m_allLayersMap[i][1]] = rects::RectSet::bake(*this, i);
+				}, &counter);
+			}
+		}
+		if(m_clearances.empty()) {
+			m_clearances.resize(m_tileLayers.size());
+			for(auto i = 0u; i < m_allLayersMap.size(); ++i) {
+				if(m_allLayersMap[i][0] == 0) {
+					jobSystem->run([this, i]() {
+						m_clearances[m_allLayersMap[i][1]] = clearance::Field::bake(*this, i);
+					}, &counter);
+				}
+			}
+		}
+		jobSystem->wait(counter);
+
+		// Create textures on the calling thread:
+		std::map< std::string, std::shared_ptr<texture::Texture> > textures;
+		for(size_t i = 0; i < imageFiles.size(); ++i) {
+			if(decodeImage && images[i] == 0) {
+				util::ERR("Failed to load image file: \"" + imageFiles[i] + "\"!");
+			}
+			auto texture = createTexture(imageFiles[i], images[i] ? *images[i] : DecodedImage());
+			if(texture == 0) {
+				util::ERR("Failed to load texture file: \"" + imageFiles[i] + "\"!");
+			}
+			util::INFO("Loaded texture: " + imageFiles[i]);
+			textures[imageFiles[i]] = texture;
+			images[i] = 0;
+		}
+		for(const auto& ts : m_tilesets) {
+			if(hasGraphics) {
+				m_tilesetTextures.push_back(textures[ts.imagePath]);
+			}
+		}
+
+		// Create a drawable object for each image layer:
+		for(auto i = 0u; i < m_layerInfos.size(); ++i) {
+			const auto& info = m_layerInfos[i];
+			if(info.type == LayerInfo::IMAGE) {
+				util::INFO("Creating map layer: index="+std::to_string(i)+", type=ImageLayer, Name=\"" + info.name + "\"");
+				assert(m_allLayersMap[i][0] == 1 && m_allLayersMap[i][1] == m_bgLayers.size());
+				std::shared_ptr<texture::Texture> texture;
+				if(info.imagePath.size() > 0 && hasGraphics) {
+					texture = textures[info.imagePath];
+					texture->setRepeat(true);
+				}
+				m_imageTextures.push_back(texture);
+				m_bgLayers.push_back(texture ? std::make_shared<ImageLayer>(info, texture, m_bounds) : 0);
+			}
+		}
+
+		// Drawable chunks of tile layers are created when they get near the view:
+		if(hasGraphics) {
+			m_chunkStreamer = std::make_shared<ChunkStreamer>(m_tileLayers, m_tilesets, m_tilesetTextures, m_tileSize);
+		}
+	}
+
+	void Map::loadTmx(const std::string& mapFilename, std::vector<TileData>& layerTiles) {
+		tmx::Map map;
+		if(false == map.load(mapFilename)) {
 			util::ERR("Failed to load map file: \"" + mapFilename + "\"!");
 		}
 		util::INFO("Loaded Tiled map: " + mapFilename);
 
-		m_clearColor.r = m_map->getBackgroundColour().r/255.0f;
-		m_clearColor.g = m_map->getBackgroundColour().g/255.0f;
-		m_clearColor.b = m_map->getBackgroundColour().b/255.0f;
-		m_clearColor.a = m_map->getBackgroundColour().a/255.0f;
-		// Create tileset textures from map tilesets:
-		for(const auto& ts : m_map->getTilesets()) {
-			auto texture = loadTexture(ts.getImagePath());
-			if(texture == 0) {
-				util::ERR("Failed to load tileset texture file: \"" + ts.getImagePath() + "\"!");
+		m_clearColor.r = map.getBackgroundColour().r/255.0f;
+		m_clearColor.g = map.getBackgroundColour().g/255.0f;
+		m_clearColor.b = map.getBackgroundColour().b/255.0f;
+		m_clearColor.a = map.getBackgroundColour().a/255.0f;
+		m_mapSize = {map.getTileCount().x, map.getTileCount().y};
+		m_tileSize = {map.getTileSize().x, map.getTileSize().y};
+		const auto& layers = map.getLayers();
+		// Infinite maps have tiles in chunks at any tile position. Map is the bounding box of the
+		// chunks of all tile layers, with top left chunk tile at 0,0.
+		tmx::Vector2i origin(0, 0);
+		if(map.isInfinite()) {
+			tmx::Vector2i minPos(std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
+			tmx::Vector2i maxPos(std::numeric_limits<int>::lowest(), std::numeric_limits<int>::lowest());
+			for(const auto& layer : layers) {
+				if(layer->getType() != tmx::Layer::Type::Tile) {
+					continue;
+				}
+				for(const auto& chunk : dynamic_cast<const tmx::TileLayer*>(layer.get())->getChunks()) {
+					minPos.x = std::min(minPos.x, chunk.position.x);
+					minPos.y = std::min(minPos.y, chunk.position.y);
+					maxPos.x = std::max(maxPos.x, chunk.position.x + chunk.size.x);
+					maxPos.y = std::max(maxPos.y, chunk.position.y + chunk.size.y);
+				}
+			}
+			if(minPos.x > maxPos.x) {
+				minPos = maxPos = tmx::Vector2i(0, 0);
 			}
-			util::INFO("Loaded tileset texture: " + ts.getImagePath());
-			m_tilesetTextures.push_back(texture);
+			origin = minPos;
+			m_mapSize = {size_t(maxPos.x - minPos.x), size_t(maxPos.y - minPos.y)};
+			util::INFO("Infinite map: " + std::to_string(m_mapSize.x) + "x" + std::to_string(m_mapSize.y) + " tiles from tile " + std::to_string(origin.x) + "," + std::to_string(origin.y));
+		}
+		m_bounds = glm::vec4(0, 0, float(m_mapSize.x * m_tileSize.x), float(m_mapSize.y * m_tileSize.y));
+
+		for(const auto& ts : map.getTilesets()) {
+			TilesetInfo info;
+			info.imagePath = ts.getImagePath();
+			info.firstGID = ts.getFirstGID();
+			info.tileCount = ts.getTileCount();
+			info.columns = ts.getColumnCount();
+			info.tileSize = {ts.getTileSize().x, ts.getTileSize().y};
+			m_tilesets.push_back(info);
 		}
 
-		// Create all rest textures for each layers:
-		const auto& layers = m_map->getLayers();
+		std::vector<objects::ObjectSet::ObjectInfo> objectInfos;
 		for(auto layerIndex = 0u; layerIndex < layers.size(); ++layerIndex) {
 			const auto layerType = layers[layerIndex]->getType();
+			LayerInfo info;
+			info.name = layers[layerIndex]->getName();
+			info.opacity = layers[layerIndex]->getOpacity();
+			info.offset = {layers[layerIndex]->getOffset().x, layers[layerIndex]->getOffset().y};
 			if(layerType == tmx::Layer::Type::Tile) {
-			} else if(layerType == tmx::Layer::Type::Group) {
-				util::INFO("Creating map layer: index="+std::to_string(layerIndex)+", type=Group, Name=\"" + m_map->getLayers()[layerIndex]->getName() + "\"");
-				util::WARN("Group layers are not supported in tmx-maps");
-			} else if(layerType == tmx::Layer::Type::Image) {
-				const tmx::ImageLayer& layer = *dynamic_cast<tmx::ImageLayer*>(m_map->getLayers()[layerIndex].get());
-				auto imgPath = layer.getImagePath();
-				if(imgPath.size() > 0) {
-					auto texture = loadTexture(imgPath);
-					texture->setRepeat(true);
-					if(texture == 0) {
-						util::ERR("Failed to load image texture file: \"" + imgPath + "\"!");
+				const tmx::TileLayer& layer = *dynamic_cast<tmx::TileLayer*>(layers[layerIndex].get());
+				auto copyTiles = [&info](TileData& tiles, const std::vector<tmx::TileLayer::Tile>& tmxTiles, int x0, int y0, int width, int height) {
+					if(tmxTiles.size() < size_t(width * height)) {
+						util::ERR("Missing tiles in layer \"" + info.name + "\"!");
+					}
+					for(int ly = 0; ly < height; ++ly) {
+						for(int lx = 0; lx < width; ++lx) {
+							const auto& layerTile = tmxTiles[ly * width + lx];
+							if(layerTile.ID > TileData::MAX_ID) {
+								util::ERR("Tile id " + std::to_string(layerTile.ID) + " of layer \"" + info.name + "\" is too large!");
+							} else if(layerTile.ID > 0) {
+								tiles.set(x0 + lx, y0 + ly, int(layerTile.ID), int(layerTile.flipFlags));
+							}
+						}
+					}
+				};
+				TileData tiles(m_mapSize.x, m_mapSize.y);
+				if(map.isInfinite()) {
+					for(const auto& chunk : layer.getChunks()) {
+						copyTiles(tiles, chunk.tiles, chunk.position.x - origin.x, chunk.position.y - origin.y, chunk.size.x, chunk.size.y);
 					}
-					util::INFO("Loaded image texture: " + imgPath);
-					m_imageTextures.push_back(texture);
 				} else {
-					m_imageTextures.push_back(0);
+					const auto& layerSize = layer.getSize();
+					if(layerSize.x != m_mapSize.x || layerSize.y != m_mapSize.y) {
+						util::ERR("Size of layer \"" + info.name + "\" differs from map size!");
+					}
+					copyTiles(tiles, layer.getTiles(), 0, 0, int(layerSize.x), int(layerSize.y));
 				}
+				info.type = LayerInfo::TILE;
+				m_allLayersMap.push_back({0,layerTiles.size()});
+				m_layerInfos.push_back(info);
+				layerTiles.push_back(tiles);
+			} else if(layerType == tmx::Layer::Type::Image) {
+				const tmx::ImageLayer& layer = *dynamic_cast<tmx::ImageLayer*>(layers[layerIndex].get());
+				info.type = LayerInfo::IMAGE;
+				info.imagePath = layer.getImagePath();
+				info.repeat = {layer.getRepeat().x, layer.getRepeat().y};
+				info.parallaxFactor = {layer.getParallax().x, layer.getParallax().y};
+				info.hasTransparency = layer.hasTransparency();
+				const auto& c = layer.getTransparencyColour();
+				info.transparentColor = glm::vec4(c.r, c.g, c.b, c.a);
+				m_allLayersMap.push_back({1,m_layerInfos.size() - layerTiles.size()});
+				m_layerInfos.push_back(info);
+			} else if(layerType == tmx::Layer::Type::Group) {
+				util::INFO("Skipping map layer: index="+std::to_string(layerIndex)+", type=Group, Name=\"" + info.name + "\"");
+				util::WARN("Group layers are not supported in tmx-maps");
 			} else if(layerType == tmx::Layer::Type::Object) {
-				util::INFO("Creating map layer: index="+std::to_string(layerIndex)+", type=Object, Name=\"" + m_map->getLayers()[layerIndex]->getName() + "\"");
-				util::WARN("Object layers are not supported in tmx-maps");
+				// Bounds from pixels to tiles centered at integer coordinates. Rotation is ignored.
+				const auto& layer = *dynamic_cast<tmx::ObjectGroup*>(layers[layerIndex].get());
+				const auto layerOffset = glm::vec2(info.offset.x, info.offset.y) - glm::vec2(origin.x * int(m_tileSize.x), origin.y * int(m_tileSize.y));
+				const auto tileSize = glm::vec2(m_tileSize.x, m_tileSize.y);
+				for(const auto& object : layer.getObjects()) {
+					const auto& aabb = object.getAABB();
+					auto minPos = glm::vec2(aabb.left, aabb.top);
+					auto maxPos = minPos + glm::vec2(aabb.width, aabb.height);
+					if(object.getTileID() != 0) {
+						// Position of tile objects is their bottom left corner:
+						minPos.y -= aabb.height;
+						maxPos.y -= aabb.height;
+					}
+					for(const auto& point : object.getPoints()) {
+						const auto p = glm::vec2(object.getPosition().x + point.x, object.getPosition().y + point.y);
+						minPos = glm::min(minPos, p);
+						maxPos = glm::max(maxPos, p);
+					}
+					objects::ObjectSet::ObjectInfo o;
+					o.name = object.getName();
+					o.type = object.getClass();
+					o.layer = info.name;
+					o.id = object.getUID();
+					minPos = (minPos + layerOffset) / tileSize - 0.5f;
+					maxPos = (maxPos + layerOffset) / tileSize - 0.5f;
+					o.bounds = glm::vec4(minPos, maxPos);
+					objectInfos.push_back(o);
+				}
+				util::INFO("Loaded object layer: index="+std::to_string(layerIndex)+", Name=\"" + info.name + "\", objects=" + std::to_string(layer.getObjects().size()));
 			} else {
-				util::INFO("Creating map layer: index="+std::to_string(layerIndex)+", type=Unknown, Name=\"" + m_map->getLayers()[layerIndex]->getName() + "\"");
+				util::INFO("Skipping map layer: index="+std::to_string(layerIndex)+", type=Unknown, Name=\"" + info.name + "\"");
 				util::ERR("Unknown layer type in tmx-map!");
 			}
 		}
 
-		// Create a drawable object for each layer:
-		std::vector<std::string> layerNames;
-		for(auto i = 0u; i < layers.size(); ++i) {
-			const auto layerType = layers[i]->getType();
-			if(layerType == tmx::Layer::Type::Tile) {
-				m_layerNames[layers[i]->getName()] = i;
-				layerNames.push_back(layers[i]->getName());
-				m_allLayersMap.push_back({0,m_tileLayers.size()});
-				m_tileLayers.push_back(std::make_shared<TileLayer>(*m_map, i, m_tilesetTextures));
-			} else if(layerType == tmx::Layer::Type::Group) {
-				util::WARN("Group layers are not supported in tmx-maps");
-			} else if(layerType == tmx::Layer::Type::Image) {
-				m_layerNames[layers[i]->getName()] = i;
-				layerNames.push_back(layers[i]->getName());
-				m_allLayersMap.push_back({1,m_bgLayers.size()});
-				m_bgLayers.push_back(std::make_shared<ImageLayer>(*m_map, i, m_imageTextures));
-			} else if(layerType == tmx::Layer::Type::Object) {
-				util::WARN("Object layers are not supported in tmx-maps");
+		m_objects = objects::ObjectSet(objectInfos);
+
+		// Surface properties of tiles to flat table indexed by global tile id:
+		for(const auto& ts : map.getTilesets()) {
+			if(m_surfaces.size() <= ts.getLastGID()) {
+				m_surfaces.resize(ts.getLastGID() + 1);
+			}
+			for(const auto& tile : ts.getTiles()) {
+				auto& surface = m_surfaces[ts.getFirstGID() + tile.ID];
+				for(const auto& property : tile.properties) {
+					float value = 0.0f;
+					if(property.getType() == tmx::Property::Type::Float) {
+						value = property.getFloatValue();
+					} else if(property.getType() == tmx::Property::Type::Int) {
+						value = float(property.getIntValue());
+					} else {
+						continue;
+					}
+					if(property.getName() == "friction") {
+						surface.friction = value;
+					} else if(property.getName() == "speed") {
+						surface.speed = value;
+					} else if(property.getName() == "damage") {
+						surface.damage = value;
+					}
+				}
+			}
+		}
+	}
+
+	void Map::loadCooked(const std::string& mapFilename, std::vector<TileData>& layerTiles) {
+		auto file = util::MappedFile::open(mapFilename);
+		if(file == 0) {
+			util::ERR("Failed to load map file: \"" + mapFilename + "\"!");
+		}
+		auto invalid = [&mapFilename](const std::string& reason) {
+			util::ERR("Invalid cooked map file: \"" + mapFilename + "\": " + reason + "!");
+		};
+		uint8_t* data = file->getData();
+		const uint64_t fileSize = file->getSize();
+		// Is size bytes at offset inside the file and aligned:
+		auto isInFile = [fileSize](uint64_t offset, uint64_t size) {
+			return offset % 8 == 0 && offset <= fileSize && size <= fileSize - offset;
+		};
+
+		if(fileSize < sizeof(CookedHeader)) {
+			invalid("file is too small");
+		}
+		const auto& header = *reinterpret_cast<const CookedHeader*>(data);
+		if(std::memcmp(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC)) != 0) {
+			invalid("not a cooked map");
+		}
+		if(header.endian != COOKED_ENDIAN) {
+			invalid("byte order mismatch");
+		}
+		if(header.version != COOKED_VERSION) {
+			invalid("version " + std::to_string(header.version) + ", expected " + std::to_string(COOKED_VERSION));
+		}
+		if(header.fileSize != fileSize
+			|| false == isInFile(header.tilesetsOffset, uint64_t(header.numTilesets)*sizeof(CookedTileset))
+			|| false == isInFile(header.layersOffset, uint64_t(header.numLayers)*sizeof(CookedLayer))
+			|| false == isInFile(header.surfacesOffset, uint64_t(header.numSurfaces)*sizeof(Surface))
+			|| false == isInFile(header.objectsOffset, uint64_t(header.numObjects)*sizeof(CookedObject))
+			|| false == isInFile(header.stringsOffset, header.stringsSize)
+			|| header.numSurfaces == 0) {
+			invalid("file is truncated or corrupted");
+		}
+		const char* strings = reinterpret_cast<const char*>(data + header.stringsOffset);
+		auto getString = [&](const CookedString& s) {
+			if(uint64_t(s.offset) + s.length > header.stringsSize) {
+				invalid("string out of range");
+			}
+			return std::string(strings + s.offset, s.length);
+		};
+
+		m_clearColor = glm::vec4(header.clearColor[0], header.clearColor[1], header.clearColor[2], header.clearColor[3]);
+		m_mapSize = {header.mapSize[0], header.mapSize[1]};
+		m_tileSize = {header.tileSize[0], header.tileSize[1]};
+		m_bounds = glm::vec4(header.bounds[0], header.bounds[1], header.bounds[2], header.bounds[3]);
+
+		const auto* tilesets = reinterpret_cast<const CookedTileset*>(data + header.tilesetsOffset);
+		for(auto i = 0u; i < header.numTilesets; ++i) {
+			const auto& ts = tilesets[i];
+			TilesetInfo info;
+			info.imagePath = getString(ts.imagePath);
+			info.firstGID = ts.firstGID;
+			info.tileCount = ts.tileCount;
+			info.columns = ts.columns;
+			info.tileSize = {ts.tileSize[0], ts.tileSize[1]};
+			m_tilesets.push_back(info);
+		}
+
+		// Tiles and distance fields are used in place, sharing ownership of the mapped file:
+		const uint64_t numTiles = uint64_t(m_mapSize.x)*m_mapSize.y;
+		const auto* layers = reinterpret_cast<const CookedLayer*>(data + header.layersOffset);
+		for(auto i = 0u; i < header.numLayers; ++i) {
+			const auto& layer = layers[i];
+			LayerInfo info;
+			info.name = getString(layer.name);
+			info.opacity = layer.opacity;
+			info.offset = {layer.offset[0], layer.offset[1]};
+			if(layer.type == LayerInfo::TILE) {
+				if(false == isInFile(layer.tilesOffset, numTiles*sizeof(uint16_t))
+					|| false == isInFile(layer.distancesOffset, numTiles*sizeof(int16_t))) {
+					invalid("tiles of layer \"" + info.name + "\" out of range");
+				}
+				info.type = LayerInfo::TILE;
+				auto tiles = std::shared_ptr<uint16_t>(file, reinterpret_cast<uint16_t*>(data + layer.tilesOffset));
+				auto distances = std::shared_ptr<int16_t>(file, reinterpret_cast<int16_t*>(data + layer.distancesOffset));
+				m_allLayersMap.push_back({0,layerTiles.size()});
+				layerTiles.push_back(TileData(m_mapSize.x, m_mapSize.y, tiles));
+				m_clearances.push_back(clearance::Field::view(m_mapSize, distances));
+			} else if(layer.type == LayerInfo::IMAGE) {
+				info.type = LayerInfo::IMAGE;
+				info.imagePath = getString(layer.imagePath);
+				info.repeat = {layer.repeat[0], layer.repeat[1]};
+				info.parallaxFactor = {layer.parallaxFactor[0], layer.parallaxFactor[1]};
+				info.hasTransparency = layer.hasTransparency != 0;
+				info.transparentColor = glm::vec4(layer.transparentColor[0], layer.transparentColor[1], layer.transparentColor[2], layer.transparentColor[3]);
+				m_allLayersMap.push_back({1,m_layerInfos.size() - layerTiles.size()});
 			} else {
-				util::ERR("Unknown layer type in tmx-map!");
+				invalid("unknown type of layer \"" + info.name + "\"");
 			}
+			m_layerInfos.push_back(info);
 		}
+
+		const auto* surfaces = reinterpret_cast<const Surface*>(data + header.surfacesOffset);
+		m_surfaces.assign(surfaces, surfaces + header.numSurfaces);
+
+		// Objects are cooked in tree order, so building the set only rebuilds the tree:
+		const auto* cookedObjects = reinterpret_cast<const CookedObject*>(data + header.objectsOffset);
+		std::vector<objects::ObjectSet::ObjectInfo> objectInfos;
+		for(auto i = 0u; i < header.numObjects; ++i) {
+			const auto& object = cookedObjects[i];
+			objects::ObjectSet::ObjectInfo o;
+			o.name = getString(object.name);
+			o.type = getString(object.type);
+			o.layer = getString(object.layer);
+			o.bounds = glm::vec4(object.bounds[0], object.bounds[1], object.bounds[2], object.bounds[3]);
+			o.id = object.id;
+			objectInfos.push_back(o);
+		}
+		m_objects = objects::ObjectSet(objectInfos);
+		util::INFO("Loaded cooked map: " + mapFilename);
+	}
+
+	void Map::cook(const std::string& fileName) const {
+		std::vector<uint8_t> bytes(sizeof(CookedHeader), 0);
+		// Appends data at next 8 byte aligned offset and returns the offset:
+		auto append = [&bytes](const void* data, size_t size) {
+			bytes.resize((bytes.size() + 7) & ~size_t(7), 0);
+			const uint64_t offset = bytes.size();
+			const auto* begin = reinterpret_cast<const uint8_t*>(data);
+			bytes.insert(bytes.end(), begin, begin + size);
+			return offset;
+		};
+		std::string strings;
+		auto addString = [&strings](const std::string& s) {
+			CookedString result = {uint32_t(strings.size()), uint32_t(s.size())};
+			strings += s;
+			return result;
+		};
+
+		std::vector<CookedTileset> tilesets;
+		for(const auto& ts : m_tilesets) {
+			CookedTileset t = {};
+			t.imagePath = addString(ts.imagePath);
+			t.firstGID = ts.firstGID;
+			t.tileCount = ts.tileCount;
+			t.columns = ts.columns;
+			t.tileSize[0] = uint32_t(ts.tileSize.x);
+			t.tileSize[1] = uint32_t(ts.tileSize.y);
+			tilesets.push_back(t);
+		}
+
+		std::vector<CookedLayer> layers;
+		const size_t numTiles = m_mapSize.x*m_mapSize.y;
+		for(auto i = 0u; i < m_layerInfos.size(); ++i) {
+			const auto& info = m_layerInfos[i];
+			CookedLayer l = {};
+			l.name = addString(info.name);
+			l.type = uint32_t(info.type);
+			l.opacity = info.opacity;
+			l.offset[0] = int32_t(info.offset.x);
+			l.offset[1] = int32_t(info.offset.y);
+			if(info.type == LayerInfo::TILE) {
+				const auto layerIndex = m_allLayersMap[i][1];
+				const auto& tiles = m_tileLayers[layerIndex]->tiles;
+				const auto& field = m_clearances[layerIndex];
+				if(tiles.getWidth() != m_mapSize.x || tiles.getHeight() != m_mapSize.y) {
+					util::ERR("Can't cook layer \"" + info.name + "\": layer size differs from map size!");
+				}
+				l.tilesOffset = append(tiles.getData(), numTiles*sizeof(uint16_t));
+				l.distancesOffset = append(field.getData(), numTiles*sizeof(int16_t));
+			} else {
+				l.imagePath = addString(info.imagePath);
+				l.repeat[0] = uint32_t(info.repeat.x);
+				l.repeat[1] = uint32_t(info.repeat.y);
+				l.parallaxFactor[0] = info.parallaxFactor.x;
+				l.parallaxFactor[1] = info.parallaxFactor.y;
+				l.hasTransparency = info.hasTransparency ? 1 : 0;
+				for(int c = 0; c < 4; ++c) {
+					l.transparentColor[c] = info.transparentColor[c];
+				}
+			}
+			layers.push_back(l);
+		}
+
+		std::vector<CookedObject> cookedObjects;
+		for(const auto& object : m_objects) {
+			CookedObject o = {};
+			o.name = addString(std::string(object.name));
+			o.type = addString(std::string(object.type));
+			o.layer = addString(std::string(object.layer));
+			for(int i = 0; i < 4; ++i) {
+				o.bounds[i] = object.bounds[i];
+			}
+			o.id = object.id;
+			cookedObjects.push_back(o);
+		}
+
+		CookedHeader header = {};
+		std::memcpy(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC));
+		header.version = COOKED_VERSION;
+		header.endian = COOKED_ENDIAN;
+		header.mapSize[0] = uint32_t(m_mapSize.x);
+		header.mapSize[1] = uint32_t(m_mapSize.y);
+		header.tileSize[0] = uint32_t(m_tileSize.x);
+		header.tileSize[1] = uint32_t(m_tileSize.y);
+		for(int i = 0; i < 4; ++i) {
+			header.clearColor[i] = m_clearColor[i];
+			header.bounds[i] = m_bounds[i];
+		}
+		header.numTilesets = uint32_t(tilesets.size());
+		header.numLayers = uint32_t(layers.size());
+		header.numSurfaces = uint32_t(m_surfaces.size());
+		header.numObjects = uint32_t(cookedObjects.size());
+		header.stringsSize = uint32_t(strings.size());
+		header.tilesetsOffset = append(tilesets.data(), tilesets.size()*sizeof(CookedTileset));
+		header.layersOffset = append(layers.data(), layers.size()*sizeof(CookedLayer));
+		header.surfacesOffset = append(m_surfaces.data(), m_surfaces.size()*sizeof(Surface));
+		header.objectsOffset = append(cookedObjects.data(), cookedObjects.size()*sizeof(CookedObject));
+		header.stringsOffset = append(strings.data(), strings.size());
+		bytes.resize((bytes.size() + 7) & ~size_t(7), 0);
+		header.fileSize = bytes.size();
+		std::memcpy(bytes.data(), &header, sizeof(header));
+
+		std::ofstream out(fileName, std::ios::binary);
+		out.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+		if(false == out.good()) {
+			util::ERR("Failed to write cooked map file: \"" + fileName + "\"!");
+		}
+		util::INFO("Cooked map: " + fileName + ", " + std::to_string(bytes.size()) + " bytes");
 	}
 
 	size2d_t Map::getTileSize() const {
-		auto& s = m_map->getTileSize();
-		return {s.x, s.y};
+		return m_tileSize;
 	}
 
 	size2d_t Map::getMapSize() const {
-		auto& s = m_map->getTileCount();
-		return {s.x, s.y};
+		return m_mapSize;
 	}
 
 
 	Map::MapCollision Map::checkCollision(const std::string& layerName, const glm::vec3 position, glm::vec3 halfSize) const {
+		return checkCollision(getLayerHandle(layerName), position, halfSize);
+	}
+
+	Map::MapCollision Map::checkCollision(LayerHandle layer, const glm::vec3 position, glm::vec3 halfSize) const {
 		// Ckeck map limits
 		auto mapSize = getMapSize();
 		mapSize.x -= 1;
@@ -270,8 +716,7 @@ namespace map {
 			colMap[p.y][p.x].z = getValue(colMap[p.y][p.x].z, val.z);
 		};
 
-		auto getOverlap = [this,&layerName](int2d_t mapDir, glm::vec3 position, const glm::vec3& halfSize) {
-			auto layer = getLayerIndex(layerName);
+		auto getOverlap = [this,layer](int2d_t mapDir, glm::vec3 position, const glm::vec3& halfSize) {
 			//position -= glm::vec3(0.5, 0.5, 0.0);
 			int2d_t pos = {int(position.x+0.5f),int(position.y+0.5f)};
 			int mx = mapDir.x + pos.x;
@@ -341,6 +786,307 @@ namespace map {
 		return colMap;
 	}
 
+	bool Map::hasGraphics() const {
+		return m_tileLayerShader != 0;
+	}
+
+	Map::Contact Map::checkCollisionOBB(const std::string& layerName, const glm::vec2& position, const glm::vec2& halfSize, float angle) const {
+		return checkCollisionOBB(getLayerHandle(layerName), position, halfSize, angle);
+	}
+
+	Map::Contact Map::checkCollisionOBB(LayerHandle layer, const glm::vec2& position, const glm::vec2& halfSize, float angle) const {
+		float s, c;
+		math::sincos(angle, s, c);
+		const glm::vec2 axisU(c, s);
+		const glm::vec2 axisV(-s, c);
+		// Bounds of rotated box:
+		const float ex = std::abs(c)*halfSize.x + std::abs(s)*halfSize.y;
+		const float ey = std::abs(s)*halfSize.x + std::abs(c)*halfSize.y;
+		// Tile at (x,y) covers area [x-0.5, x+0.5]:
+		const int x0 = int(std::floor(position.x - ex + 0.5f));
+		const int x1 = int(std::floor(position.x + ex + 0.5f));
+		const int y0 = int(std::floor(position.y - ey + 0.5f));
+		const int y1 = int(std::floor(position.y + ey + 0.5f));
+
+		Contact res;
+		glm::vec2 sumNormal(0);
+		getCollisionRects(layer).forEachOverlapping(x0, y0, x1, y1, [&](const rects::Rect& rect) {
+			// Separating axis test of box and rectangle. Axes are map x and y and box u and v:
+			const glm::vec2 d = position - rect.getCenter();
+			const glm::vec2 rectHalfSize = rect.getHalfSize();
+			const glm::vec2 axes[4] = { glm::vec2(1, 0), glm::vec2(0, 1), axisU, axisV };
+			float minOverlap = 0;
+			glm::vec2 normal(0);
+			for(const auto& axis : axes) {
+				const float boxRadius = halfSize.x*std::abs(glm::dot(axisU, axis)) + halfSize.y*std::abs(glm::dot(axisV, axis));
+				const float rectRadius = rectHalfSize.x*std::abs(axis.x) + rectHalfSize.y*std::abs(axis.y);
+				const float dist = glm::dot(d, axis);
+				const float overlap = boxRadius + rectRadius - std::abs(dist);
+				if(overlap <= 0.0f) {
+					return; // Separated
+				}
+				if(normal == glm::vec2(0) || overlap < minOverlap) {
+					minOverlap = overlap;
+					normal = dist < 0.0f ? -axis : axis;
+				}
+			}
+			res.hit = true;
+			res.depth = std::max(res.depth, minOverlap);
+			sumNormal += minOverlap * normal;
+		});
+		if(res.hit) {
+			const float len = glm::length(sumNormal);
+			// Opposite contacts may cancel each other, then use the deepest axis direction of the box.
+			res.normal = len > 0.0f ? sumNormal / len : axisU;
+		}
+		return res;
+	}
+
+	void Map::checkCollisions(size_t layerId, const BoxQuery* queries, size_t count, Contact* results) const {
+		checkCollisions(getLayerHandle(layerId), queries, count, results);
+	}
+
+	void Map::checkCollisions(LayerHandle layer, const BoxQuery* queries, size_t count, Contact* results) const {
+		// Scratch buffers are kept over calls to avoid allocations:
+		thread_local std::vector<uint32_t>	order;
+		thread_local std::vector<uint32_t>	rowStart;
+		thread_local std::vector<uint32_t>	candQuery;
+		thread_local std::vector<float>		candDx, candDy, candHx, candHy, overlapX, overlapY;
+		const auto& rects = getCollisionRects(layer);
+		const int sy = int(getMapSize().y);
+		// Tile at (x,y) covers area [x-0.5, x+0.5]:
+		auto toTile = [](float v) {
+			return int(std::floor(v + 0.5f));
+		};
+
+		// Counting sort queries by their first tile row. Rows outside of the map go to first and last bucket:
+		const size_t numRows = size_t(sy) + 2;
+		auto getRow = [&](const BoxQuery& q) {
+			return size_t(std::clamp(toTile(q.position.y - q.halfSize.y) + 1, 0, int(numRows) - 1));
+		};
+		rowStart.assign(numRows + 1, 0);
+		for(size_t i = 0; i < count; ++i) {
+			++rowStart[getRow(queries[i]) + 1];
+		}
+		for(size_t r = 0; r < numRows; ++r) {
+			rowStart[r + 1] += rowStart[r];
+		}
+		order.resize(count);
+		for(size_t i = 0; i < count; ++i) {
+			order[rowStart[getRow(queries[i])]++] = uint32_t(i);
+		}
+
+		// Gather collision rectangles overlapped by bounds of each query:
+		candQuery.clear();
+		candDx.clear();
+		candDy.clear();
+		candHx.clear();
+		candHy.clear();
+		for(const auto queryId : order) {
+			const auto& q = queries[queryId];
+			results[queryId] = Contact();
+			const int x0 = toTile(q.position.x - q.halfSize.x);
+			const int x1 = toTile(q.position.x + q.halfSize.x);
+			const int y0 = toTile(q.position.y - q.halfSize.y);
+			const int y1 = toTile(q.position.y + q.halfSize.y);
+			rects.forEachOverlapping(x0, y0, x1, y1, [&](const rects::Rect& rect) {
+				const auto center = rect.getCenter();
+				const auto rectHalfSize = rect.getHalfSize();
+				candQuery.push_back(queryId);
+				candDx.push_back(q.position.x - center.x);
+				candDy.push_back(q.position.y - center.y);
+				candHx.push_back(q.halfSize.x + rectHalfSize.x);
+				candHy.push_back(q.halfSize.y + rectHalfSize.y);
+			});
+		}
+
+		// Overlaps of boxes and rectangles along x and y:
+		const size_t n = candQuery.size();
+		overlapX.resize(n);
+		overlapY.resize(n);
+		size_t i = 0;
+#if defined(HUNGERLAND_MAP_SSE)
+		const auto signMask = _mm_set1_ps(-0.0f);
+		for(; i + 4 <= n; i += 4) {
+			const auto dx = _mm_andnot_ps(signMask, _mm_loadu_ps(&candDx[i]));
+			const auto dy = _mm_andnot_ps(signMask, _mm_loadu_ps(&candDy[i]));
+			_mm_storeu_ps(&overlapX[i], _mm_sub_ps(_mm_loadu_ps(&candHx[i]), dx));
+			_mm_storeu_ps(&overlapY[i], _mm_sub_ps(_mm_loadu_ps(&candHy[i]), dy));
+		}
+#endif
+		for(; i < n; ++i) {
+			overlapX[i] = candHx[i] - std::abs(candDx[i]);
+			overlapY[i] = candHy[i] - std::abs(candDy[i]);
+		}
+
+		// Combine contacts of each query like checkCollisionOBB: deepest depth and sum normal.
+		for(i = 0; i < n; ++i) {
+			const float ox = overlapX[i];
+			const float oy = overlapY[i];
+			if(ox <= 0.0f || oy <= 0.0f) {
+				continue;
+			}
+			auto& res = results[candQuery[i]];
+			const float depth = std::min(ox, oy);
+			const auto normal = ox <= oy ? glm::vec2(candDx[i] < 0.0f ? -1.0f : 1.0f, 0.0f) : glm::vec2(0.0f, candDy[i] < 0.0f ? -1.0f : 1.0f);
+			res.hit = true;
+			res.depth = std::max(res.depth, depth);
+			res.normal += depth * normal;
+		}
+		for(size_t queryId = 0; queryId < count; ++queryId) {
+			auto& res = results[queryId];
+			if(res.hit) {
+				const float len = glm::length(res.normal);
+				res.normal = len > 0.0f ? res.normal / len : glm::vec2(0.0f, 1.0f);
+			}
+		}
+	}
+
+	namespace {
+		// DDA state of one ray. Tile at (x,y) covers area [x-0.5, x+0.5].
+		struct RayState {
+			int		cellX, cellY;
+			int		stepX, stepY;
+			float	tMaxX, tMaxY;	// Distance to next cell edge along x and y.
+			float	tDeltaX, tDeltaY;	// Distance between cell edges along x and y.
+		};
+
+		RayState initRay(const glm::vec2& origin, const glm::vec2& direction) {
+			const float INF = std::numeric_limits<float>::infinity();
+			const glm::vec2 u = origin + glm::vec2(0.5f);
+			RayState r;
+			r.cellX = int(std::floor(u.x));
+			r.cellY = int(std::floor(u.y));
+			r.stepX = direction.x < 0.0f ? -1 : 1;
+			r.stepY = direction.y < 0.0f ? -1 : 1;
+			r.tDeltaX = direction.x != 0.0f ? std::abs(1.0f / direction.x) : INF;
+			r.tDeltaY = direction.y != 0.0f ? std::abs(1.0f / direction.y) : INF;
+			r.tMaxX = direction.x != 0.0f ? (r.stepX > 0 ? float(r.cellX + 1) - u.x : u.x - float(r.cellX)) * r.tDeltaX : INF;
+			r.tMaxY = direction.y != 0.0f ? (r.stepY > 0 ? float(r.cellY + 1) - u.y : u.y - float(r.cellY)) * r.tDeltaY : INF;
+			return r;
+		}
+	}
+
+	Map::RayHit Map::raycast(size_t layerId, const glm::vec2& origin, const glm::vec2& direction, float maxDistance, bool hitEmpty) const {
+		return raycast(getLayerHandle(layerId), origin, direction, maxDistance, hitEmpty);
+	}
+
+	Map::RayHit Map::raycast(LayerHandle layer, const glm::vec2& origin, const glm::vec2& direction, float maxDistance, bool hitEmpty) const {
+		assert(layer.tileLayerId < m_layerTiles.size());
+		const auto& tiles = m_layerTiles[layer.tileLayerId];
+		const auto mapSize = getMapSize();
+		auto isStop = [&](int x, int y) {
+			if(x < 0 || y < 0 || size_t(x) >= mapSize.x || size_t(y) >= mapSize.y) {
+				return true;
+			}
+			return hitEmpty ? tiles.getId(x, y) <= 0 : tiles.getId(x, y) > 0;
+		};
+		auto r = initRay(origin, direction);
+		RayHit hit;
+		hit.tile = {r.cellX, r.cellY};
+		if(isStop(r.cellX, r.cellY)) {
+			hit.hit = true;
+			return hit;
+		}
+		hit.distance = maxDistance;
+		while(true) {
+			const bool alongX = r.tMaxX < r.tMaxY;
+			const float t = alongX ? r.tMaxX : r.tMaxY;
+			if(t > maxDistance) {
+				return hit; // Missed
+			}
+			if(alongX) {
+				r.cellX += r.stepX;
+				r.tMaxX += r.tDeltaX;
+			} else {
+				r.cellY += r.stepY;
+				r.tMaxY += r.tDeltaY;
+			}
+			if(isStop(r.cellX, r.cellY)) {
+				hit.hit = true;
+				hit.distance = t;
+				hit.normal = alongX ? glm::vec2(float(-r.stepX), 0.0f) : glm::vec2(0.0f, float(-r.stepY));
+				hit.tile = {r.cellX, r.cellY};
+				return hit;
+			}
+		}
+	}
+
+	void Map::raycastSensors(size_t layerId, const glm::vec2* origins, const float* headings, size_t numAgents,
+		const float* rayAngles, size_t numRays, float maxDistance, RayHit* hits, bool hitEmpty) const {
+		raycastSensors(getLayerHandle(layerId), origins, headings, numAgents, rayAngles, numRays, maxDistance, hits, hitEmpty);
+	}
+
+	void Map::raycastSensors(LayerHandle layer, const glm::vec2* origins, const float* headings, size_t numAgents,
+		const float* rayAngles, size_t numRays, float maxDistance, RayHit* hits, bool hitEmpty) const {
+		thread_local std::vector<RayState>	rays;
+		thread_local std::vector<uint32_t>	active;
+		assert(layer.tileLayerId < m_layerTiles.size());
+		const auto& tiles = m_layerTiles[layer.tileLayerId];
+		const auto mapSize = getMapSize();
+		const int sx = int(mapSize.x);
+		const int sy = int(mapSize.y);
+		auto isStop = [&](int x, int y) {
+			if(x < 0 || y < 0 || x >= sx || y >= sy) {
+				return true;
+			}
+			return hitEmpty ? tiles.getId(x, y) <= 0 : tiles.getId(x, y) > 0;
+		};
+
+		// Initialize all rays. Rays starting in stopping tile hit at distance zero:
+		const size_t numTotal = numAgents * numRays;
+		rays.resize(numTotal);
+		active.clear();
+		for(size_t a = 0; a < numAgents; ++a) {
+			for(size_t k = 0; k < numRays; ++k) {
+				const size_t i = a*numRays + k;
+				const float angle = headings[a] + rayAngles[k];
+				float s, c;
+				math::sincos(angle, s, c);
+				rays[i] = initRay(origins[a], glm::vec2(c, s));
+				auto& hit = hits[i];
+				hit = RayHit();
+				hit.tile = {rays[i].cellX, rays[i].cellY};
+				if(isStop(rays[i].cellX, rays[i].cellY)) {
+					hit.hit = true;
+				} else {
+					hit.distance = maxDistance;
+					active.push_back(uint32_t(i));
+				}
+			}
+		}
+
+		// Step active rays one cell at a time, removing finished ones:
+		while(false == active.empty()) {
+			size_t numActive = 0;
+			for(const auto i : active) {
+				auto& r = rays[i];
+				const bool alongX = r.tMaxX < r.tMaxY;
+				const float t = alongX ? r.tMaxX : r.tMaxY;
+				if(t > maxDistance) {
+					continue; // Missed
+				}
+				if(alongX) {
+					r.cellX += r.stepX;
+					r.tMaxX += r.tDeltaX;
+				} else {
+					r.cellY += r.stepY;
+					r.tMaxY += r.tDeltaY;
+				}
+				if(isStop(r.cellX, r.cellY)) {
+					auto& hit = hits[i];
+					hit.hit = true;
+					hit.distance = t;
+					hit.normal = alongX ? glm::vec2(float(-r.stepX), 0.0f) : glm::vec2(0.0f, float(-r.stepY));
+					hit.tile = {r.cellX, r.cellY};
+					continue;
+				}
+				active[numActive++] = i;
+			}
+			active.resize(numActive);
+		}
+	}
+
 	const size_t Map::getNumLayers() const {
 		return m_tileLayers.size();
 	}
@@ -353,17 +1099,108 @@ namespace map {
 		return it->second;
 	}
 
-	const int Map::getTileId(size_t layerId, size_t x, size_t y) const {
-		if(x < 0.0f || y < 0.0f) {
-			return -1;
+	Map::LayerHandle Map::getLayerHandle(const std::string& name) const {
+		return getLayerHandle(getLayerIndex(name));
+	}
+
+	Map::LayerHandle Map::getLayerHandle(size_t layerId) const {
+		if(layerId >= m_allLayersMap.size() || m_allLayersMap[layerId][0] != 0) {
+			util::ERR("Layer " + std::to_string(layerId) + " is not a tile layer");
 		}
+		LayerHandle res;
+		res.layerId = uint32_t(layerId);
+		res.tileLayerId = uint32_t(m_allLayersMap[layerId][1]);
+		return res;
+	}
+
+	const clearance::Field& Map::getClearance(size_t layerId) const {
+		return getClearance(getLayerHandle(layerId));
+	}
+
+	const rects::RectSet& Map::getCollisionRects(size_t layerId) const {
+		return getCollisionRects(getLayerHandle(layerId));
+	}
+
+	const int Map::getTileId(size_t layerId, size_t x, size_t y) const {
 		auto tileLayerId = m_allLayersMap[layerId][1];
-		assert(tileLayerId < m_tileLayers.size());
-		const auto& layer = m_tileLayers[tileLayerId];
-		if(y >= layer->tileIds.size() || x >= layer->tileIds[y].size()) {
+		assert(tileLayerId < m_layerTiles.size());
+		const auto& tiles = m_layerTiles[tileLayerId];
+		if(false == tiles.contains(x, y)) {
 			return -1;
 		}
-		return layer->tileIds[y][x];
+		return tiles.getId(x, y);
+	}
+
+	void Map::setTile(size_t layerId, size_t x, size_t y, int tileId, int flipFlags) {
+		setTile(getLayerHandle(layerId), x, y, tileId, flipFlags);
+	}
+
+	void Map::setTile(LayerHandle layer, size_t x, size_t y, int tileId, int flipFlags) {
+		assert(layer.tileLayerId < m_tileLayers.size());
+		const auto tileLayerId = layer.tileLayerId;
+		auto& tiles = m_tileLayers[tileLayerId]->tiles;
+		if(false == tiles.contains(x, y)) {
+			return;
+		}
+		const bool wasSolid = tiles.getId(x, y) > 0;
+		if(m_chunkStreamer) {
+			m_chunkStreamer->setTile(tileLayerId, x, y, tileId, flipFlags);
+		} else {
+			tiles.set(x, y, tileId, flipFlags);
+		}
+		if(wasSolid != (tileId > 0)) {
+			m_clearances[tileLayerId].setSolid(x, y, tileId > 0);
+			m_collisionRects[tileLayerId].bakeArea(*this, layer.layerId, 0, int(y), int(m_mapSize.x) - 1, int(y));
+		}
+		++m_revision;
+	}
+
+	void Map::setTiles(size_t layerId, size_t x, size_t y, const TileData& tiles) {
+		setTiles(getLayerHandle(layerId), x, y, tiles);
+	}
+
+	void Map::setTiles(LayerHandle layer, size_t x, size_t y, const TileData& tiles) {
+		assert(layer.tileLayerId < m_tileLayers.size());
+		const auto tileLayerId = layer.tileLayerId;
+		auto& layerTiles = m_tileLayers[tileLayerId]->tiles;
+		bool isSolidChanged = false;
+		for(size_t ty = 0; ty < tiles.getHeight(); ++ty) {
+			for(size_t tx = 0; tx < tiles.getWidth(); ++tx) {
+				if(false == layerTiles.contains(x + tx, y + ty)) {
+					continue;
+				}
+				const int tileId = tiles.getId(tx, ty);
+				isSolidChanged |= (layerTiles.getId(x + tx, y + ty) > 0) != (tileId > 0);
+				if(m_chunkStreamer) {
+					m_chunkStreamer->setTile(tileLayerId, x + tx, y + ty, tileId, tiles.getFlags(tx, ty));
+				} else {
+					layerTiles.set(x + tx, y + ty, tileId, tiles.getFlags(tx, ty));
+				}
+			}
+		}
+		if(isSolidChanged) {
+			m_clearances[tileLayerId].bakeColumns(*this, layer.layerId, int(x), int(x + tiles.getWidth()));
+			m_collisionRects[tileLayerId].bakeArea(*this, layer.layerId, int(x), int(y), int(x + tiles.getWidth()) - 1, int(y + tiles.getHeight()) - 1);
+		}
+		++m_revision;
+	}
+
+	void Map::scrollTiles(size_t columns) {
+		if(m_chunkStreamer) {
+			m_chunkStreamer->scroll(columns);
+		} else {
+			for(auto& layer : m_tileLayers) {
+				layer->tiles.scroll(columns);
+			}
+		}
+		for(size_t layerId = 0; layerId < m_allLayersMap.size(); ++layerId) {
+			if(m_allLayersMap[layerId][0] == 0) {
+				const auto tileLayerId = m_allLayersMap[layerId][1];
+				m_clearances[tileLayerId].scroll(*this, layerId, columns);
+				m_collisionRects[tileLayerId].scroll(columns);
+			}
+		}
+		++m_revision;
 	}
 
 	template<typename Subset>
@@ -405,20 +1242,33 @@ namespace map {
 		}
 	}
 
-	void draw(const TileLayer& layer, shader::ShaderPass shader, const glm::mat4& matProjection, const glm::vec2& cameraDelta) {
-		for(const auto& subset : layer.subsets)	{
-			if(subset.used) {
-				applyLayerSubset(subset, shader, matProjection, cameraDelta);
-				shader.setUniform("tileSize", float(subset.tileSize.x), float(subset.tileSize.y));
-				shader.setUniform("tilesetSize", float(subset.tilesetSize.x), float(subset.tilesetSize.y));
-				shader.setUniform("lookupMap", 0);
-				subset.colorLookup->bind(0);
-				shader.setUniform("tileMap", 1);
-				subset.tileMap->bind(1);
-				assert(subset.mesh != 0);
-				quad::drawImage(*subset.mesh);
+	void draw(const TileSetSubset& subset, shader::ShaderPass shader, const glm::mat4& matProjection, const glm::vec2& cameraDelta) {
+		assert(subset.used);
+		applyLayerSubset(subset, shader, matProjection, cameraDelta);
+		shader.setUniform("tileSize", float(subset.tileSize.x), float(subset.tileSize.y));
+		shader.setUniform("tilesetSize", float(subset.tilesetSize.x), float(subset.tilesetSize.y));
+		shader.setUniform("lookupMap", 0);
+		subset.colorLookup->bind(0);
+		shader.setUniform("tileMap", 1);
+		subset.tileMap->bind(1);
+		assert(subset.mesh != 0);
+		quad::drawImage(*subset.mesh);
+	}
+
+	// Visible area in map pixels (left, top, right, bottom): clip space corners transformed by inverse projection.
+	glm::vec4 getView(const glm::mat4& matProjection) {
+		const auto matInverse = glm::inverse(matProjection);
+		glm::vec2 minCorner(std::numeric_limits<float>::max());
+		glm::vec2 maxCorner(std::numeric_limits<float>::lowest());
+		for(float y : {-1.0f, 1.0f}) {
+			for(float x : {-1.0f, 1.0f}) {
+				const auto p = matInverse * glm::vec4(x, y, 0.0f, 1.0f);
+				const auto corner = glm::vec2(p.x, p.y) / p.w;
+				minCorner = glm::min(minCorner, corner);
+				maxCorner = glm::max(maxCorner, corner);
 			}
 		}
+		return glm::vec4(minCorner, maxCorner);
 	}
 
 	bool isPenetrating(const Map::MapCollision& col) {
@@ -433,6 +1283,7 @@ namespace map {
 	}
 
 	void draw(const Map& map, const glm::mat4& matProjection, const glm::vec2& cameraDelta) {
+		assert(map.hasGraphics());
 		// Clear screen:
 		auto clearColor = map.getClearColor();
 		auto a = clearColor.a;
@@ -449,13 +1300,19 @@ namespace map {
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		checkGLError();
 
+		// Stream chunks of tile layers:
+		const auto view = getView(matProjection);
+		map.m_chunkStreamer->update(view);
+
 		// Render all layers:
 		for(size_t layerId=0; layerId<map.getAllLayers().size(); ++layerId) {
 			auto type = map.getAllLayers()[layerId][0];
 			auto index = map.getAllLayers()[layerId][1];
 			if(type==0) {
 				map.m_tileLayerShader->use([&](shader::ShaderPass shader) {
-					draw(*map.getTileLayers()[index], shader, matProjection, cameraDelta);
+					map.m_chunkStreamer->forEachVisible(index, view, [&](const TileSetSubset& subset) {
+						draw(subset, shader, matProjection, cameraDelta);
+					});
 				});
 			} else if(type==1) {
 				map.m_imageLayerShader->use([&](shader::ShaderPass shader) {
@@ -464,5 +1321,19 @@ namespace map {
 			}
 		}
 	}
+
+	std::string findCooked(const std::string& mapFile) {
+		std::error_code ec;
+		const std::filesystem::path path(mapFile);
+		const auto cooked = std::filesystem::path(path).replace_extension(Map::COOKED_EXTENSION);
+		if(false == std::filesystem::exists(cooked, ec)) {
+			return mapFile;
+		}
+		if(std::filesystem::exists(path, ec) && std::filesystem::last_write_time(cooked, ec) < std::filesystem::last_write_time(path, ec)) {
+			util::WARN("Cooked map \"" + cooked.string() + "\" is older than \"" + mapFile + "\", loading the map file");
+			return mapFile;
+		}
+		return cooked.string();
+	}
 }
 }
@@ -0,0 +1,107 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#include <hungerland/mapped_file.h>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hungerland {
+namespace util {
+
+#if defined(_WIN32)
+	std::shared_ptr<MappedFile> MappedFile::open(const std::string& fileName) {
+		HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		if(file == INVALID_HANDLE_VALUE) {
+			return 0;
+		}
+		LARGE_INTEGER size;
+		if(false == GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			CloseHandle(file);
+			return 0;
+		}
+		HANDLE mapping = CreateFileMappingA(file, 0, PAGE_WRITECOPY, 0, 0, 0);
+		if(mapping == 0) {
+			CloseHandle(file);
+			return 0;
+		}
+		void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+		if(data == 0) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return 0;
+		}
+		std::shared_ptr<MappedFile> res(new MappedFile());
+		res->m_data = static_cast<uint8_t*>(data);
+		res->m_size = size_t(size.QuadPart);
+		res->m_file = file;
+		res->m_mapping = mapping;
+		return res;
+	}
+
+	MappedFile::~MappedFile() {
+		if(m_data) {
+			UnmapViewOfFile(m_data);
+			CloseHandle(m_mapping);
+			CloseHandle(m_file);
+		}
+	}
+#else
+	std::shared_ptr<MappedFile> MappedFile::open(const std::string& fileName) {
+		const int fd = ::open(fileName.c_str(), O_RDONLY);
+		if(fd < 0) {
+			return 0;
+		}
+		struct stat st;
+		if(fstat(fd, &st) != 0 || st.st_size == 0) {
+			close(fd);
+			return 0;
+		}
+		void* data = mmap(0, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		// Mapping keeps the file referenced, descriptor is not needed anymore:
+		close(fd);
+		if(data == MAP_FAILED) {
+			return 0;
+		}
+		std::shared_ptr<MappedFile> res(new MappedFile());
+		res->m_data = static_cast<uint8_t*>(data);
+		res->m_size = size_t(st.st_size);
+		return res;
+	}
+
+	MappedFile::~MappedFile() {
+		if(m_data) {
+			munmap(m_data, m_size);
+		}
+	}
+#endif
+
+} // End - namespace util
+} // End - namespace hungerland
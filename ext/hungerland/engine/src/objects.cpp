@@ -0,0 +1,134 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#include <hungerland/objects.h>
+#include <algorithm>
+#include <assert.h>
+
+namespace hungerland {
+namespace objects {
+
+	namespace {
+		// Index of point x,y on Hilbert curve filling n x n grid.
+		uint64_t getHilbertIndex(uint32_t n, uint32_t x, uint32_t y) {
+			uint64_t d = 0;
+			for(uint32_t s = n/2; s > 0; s /= 2) {
+				const uint32_t rx = (x & s) > 0 ? 1 : 0;
+				const uint32_t ry = (y & s) > 0 ? 1 : 0;
+				d += uint64_t(s) * s * ((3 * rx) ^ ry);
+				// Rotate quadrant:
+				if(ry == 0) {
+					if(rx == 1) {
+						x = n - 1 - x;
+						y = n - 1 - y;
+					}
+					std::swap(x, y);
+				}
+			}
+			return d;
+		}
+	}
+
+	ObjectSet::ObjectSet(const std::vector<ObjectInfo>& objects) {
+		if(objects.empty()) {
+			return;
+		}
+		assert(objects.size() < (size_t(1) << 32));
+
+		// Sort by Hilbert index of centers in 65536 x 65536 grid over bounds of all objects:
+		const uint32_t GRID_SIZE = 1u << 16;
+		glm::vec4 total = objects[0].bounds;
+		for(const auto& o : objects) {
+			total = glm::vec4(glm::min(glm::vec2(total), glm::vec2(o.bounds)), glm::max(glm::vec2(total.z, total.w), glm::vec2(o.bounds.z, o.bounds.w)));
+		}
+		const auto scale = float(GRID_SIZE - 1) / glm::max(glm::vec2(total.z - total.x, total.w - total.y), glm::vec2(1e-6f));
+		std::vector< std::pair<uint64_t, uint32_t> > order;
+		for(size_t i = 0; i < objects.size(); ++i) {
+			const auto& b = objects[i].bounds;
+			const auto cell = (glm::vec2(b.x + b.z, b.y + b.w) * 0.5f - glm::vec2(total)) * scale;
+			order.push_back({getHilbertIndex(GRID_SIZE, uint32_t(cell.x), uint32_t(cell.y)), uint32_t(i)});
+		}
+		std::sort(order.begin(), order.end());
+
+		// Strings are appended before creating views, so the table is not reallocated under them:
+		m_strings = std::make_shared<std::string>();
+		std::vector< std::array<size_t, 3> > offsets;
+		for(const auto& o : objects) {
+			offsets.push_back({m_strings->size(), m_strings->size() + o.name.size(), m_strings->size() + o.name.size() + o.type.size()});
+			*m_strings += o.name + o.type + o.layer;
+		}
+		const std::string_view strings(*m_strings);
+		for(const auto& entry : order) {
+			const auto& info = objects[entry.second];
+			const auto& offset = offsets[entry.second];
+			Object o;
+			o.name = strings.substr(offset[0], info.name.size());
+			o.type = strings.substr(offset[1], info.type.size());
+			o.layer = strings.substr(offset[2], info.layer.size());
+			o.bounds = info.bounds;
+			o.id = info.id;
+			m_objects.push_back(o);
+			m_boxes.push_back(o.bounds);
+		}
+
+		// Levels of the tree, each node bounding NODE_SIZE nodes of the level below, until one root is left:
+		m_levelEnds.push_back(uint32_t(m_boxes.size()));
+		size_t levelStart = 0;
+		while(m_boxes.size() - levelStart > 1) {
+			const size_t levelEnd = m_boxes.size();
+			for(size_t first = levelStart; first < levelEnd; first += NODE_SIZE) {
+				glm::vec4 box = m_boxes[first];
+				for(size_t i = first + 1; i < std::min(first + NODE_SIZE, levelEnd); ++i) {
+					const auto& b = m_boxes[i];
+					box = glm::vec4(glm::min(glm::vec2(box), glm::vec2(b)), glm::max(glm::vec2(box.z, box.w), glm::vec2(b.z, b.w)));
+				}
+				m_boxes.push_back(box);
+			}
+			m_levelEnds.push_back(uint32_t(m_boxes.size()));
+			levelStart = levelEnd;
+		}
+		assert(m_levelEnds.size() <= MAX_LEVELS);
+	}
+
+	const Object* ObjectSet::find(std::string_view name) const {
+		for(const auto& o : m_objects) {
+			if(o.name == name) {
+				return &o;
+			}
+		}
+		return 0;
+	}
+
+	std::pair<uint32_t, uint32_t> ObjectSet::getChildren(uint32_t node) const {
+		size_t level = 1;
+		while(node >= m_levelEnds[level]) {
+			++level;
+		}
+		const uint32_t levelStart = m_levelEnds[level - 1];
+		const uint32_t childLevelStart = level > 1 ? m_levelEnds[level - 2] : 0;
+		const uint32_t first = childLevelStart + (node - levelStart) * uint32_t(NODE_SIZE);
+		return {first, std::min(first + uint32_t(NODE_SIZE), levelStart)};
+	}
+
+} // End - namespace objects
+} // End - namespace hungerland
@@ -0,0 +1,194 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#include <hungerland/procgen.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+	// State of random numbers used by stb_herringbone_wang_tile. Generation is serialized by generateMutex.
+	std::mutex	generateMutex;
+	uint64_t	randomState = 0;
+
+	// xorshift64* generator: same seed gives the same pattern on all platforms, unlike rand().
+	int nextRandom() {
+		randomState ^= randomState >> 12;
+		randomState ^= randomState << 25;
+		randomState ^= randomState >> 27;
+		return int((randomState * 0x2545f4914f6cdd1dull) >> 33);
+	}
+}
+
+// Seedable random numbers for stb_herringbone_wang_tile:
+#define STB_HBWANG_RAND() nextRandom()
+#define STB_HERRINGBONE_WANG_TILE_IMPLEMENTATION
+#include <stb_herringbone_wang_tile.h>
+
+namespace hungerland {
+namespace procgen {
+	WangTiles::WangTiles(int sideLength, int numColors, int numVariants, PaintFuncType paint)
+		: m_sideLength(sideLength)
+		, m_tileset(new stbhw_tileset()) {
+		assert(sideLength > 0 && numColors > 0 && numVariants > 0);
+		int numCombinations = 1;
+		for(int i = 0; i < NUM_EDGES; ++i) {
+			numCombinations *= numColors;
+		}
+		const int numTiles = numCombinations * numVariants;
+		auto& ts = *m_tileset;
+		ts.is_corner = 0;
+		ts.short_side_len = sideLength;
+		for(auto& n : ts.num_color) {
+			n = numColors;
+		}
+		// Tiles are freed by stbhw_free_tileset, so those are allocated with malloc:
+		ts.h_tiles = (stbhw_tile**)malloc(sizeof(stbhw_tile*) * numTiles);
+		ts.v_tiles = (stbhw_tile**)malloc(sizeof(stbhw_tile*) * numTiles);
+		ts.max_h_tiles = ts.max_v_tiles = numTiles;
+		const size_t numPixels = size_t(2*sideLength*sideLength);
+		std::vector<uint8_t> pixels(numPixels);
+		for(int isHorizontal = 0; isHorizontal < 2; ++isHorizontal) {
+			for(int variant = 0; variant < numVariants; ++variant) {
+				for(int combination = 0; combination < numCombinations; ++combination) {
+					int edges[NUM_EDGES];
+					for(int i = 0, c = combination; i < NUM_EDGES; ++i, c /= numColors) {
+						edges[i] = c % numColors;
+					}
+					std::fill(pixels.begin(), pixels.end(), uint8_t(0));
+					paint(isHorizontal != 0, edges, uint32_t(variant), pixels.data());
+					// Tile pixels are RGB, user bytes are in the red channel:
+					auto* tile = (stbhw_tile*)malloc(sizeof(stbhw_tile) - 1 + 3*numPixels);
+					tile->a = (signed char)edges[0];
+					tile->b = (signed char)edges[1];
+					tile->c = (signed char)edges[2];
+					tile->d = (signed char)edges[3];
+					tile->e = (signed char)edges[4];
+					tile->f = (signed char)edges[5];
+					for(size_t i = 0; i < numPixels; ++i) {
+						tile->pixels[3*i + 0] = pixels[i];
+						tile->pixels[3*i + 1] = 0;
+						tile->pixels[3*i + 2] = 0;
+					}
+					if(isHorizontal) {
+						ts.h_tiles[ts.num_h_tiles++] = tile;
+					} else {
+						ts.v_tiles[ts.num_v_tiles++] = tile;
+					}
+				}
+			}
+		}
+	}
+
+	WangTiles::~WangTiles() {
+		stbhw_free_tileset(m_tileset.get());
+	}
+
+	bool WangTiles::generate(uint64_t seed, int width, int height, uint8_t* pixels) const {
+		std::vector<uint8_t> rgb(size_t(width)*size_t(height)*3, 0);
+		{
+			std::lock_guard<std::mutex> lock(generateMutex);
+			// State of xorshift must not be zero:
+			randomState = seed*0x9e3779b97f4a7c15ull + 0x632be59bd9b4e019ull;
+			randomState = randomState != 0 ? randomState : 1;
+			if(0 == stbhw_generate_image(m_tileset.get(), 0, rgb.data(), width*3, width, height)) {
+				return false;
+			}
+		}
+		for(size_t i = 0; i < size_t(width)*size_t(height); ++i) {
+			pixels[i] = rgb[3*i];
+		}
+		return true;
+	}
+
+	ChunkGenerator::ChunkGenerator(GenerateFuncType generate)
+		: m_generate(generate) {
+		m_thread = std::thread([this]() {
+			run();
+		});
+	}
+
+	ChunkGenerator::~ChunkGenerator() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_wakeUp.notify_one();
+		m_thread.join();
+	}
+
+	void ChunkGenerator::request(int64_t index) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if(isPending(index)) {
+				return;
+			}
+			m_requests.push_back(index);
+		}
+		m_wakeUp.notify_one();
+	}
+
+	ChunkGenerator::Chunk ChunkGenerator::get(int64_t index) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if(false == isPending(index)) {
+			// Not requested: generate on the calling thread instead of waiting behind other requests.
+			lock.unlock();
+			return m_generate(index);
+		}
+		m_generated.wait(lock, [this, index]() {
+			return m_ready.count(index) > 0;
+		});
+		auto it = m_ready.find(index);
+		auto chunk = std::move(it->second);
+		m_ready.erase(it);
+		return chunk;
+	}
+
+	bool ChunkGenerator::isPending(int64_t index) const {
+		return index == m_generating || m_ready.count(index) > 0
+			|| std::find(m_requests.begin(), m_requests.end(), index) != m_requests.end();
+	}
+
+	void ChunkGenerator::run() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while(true) {
+			m_wakeUp.wait(lock, [this]() {
+				return m_quit || false == m_requests.empty();
+			});
+			if(m_quit) {
+				return;
+			}
+			const auto index = m_requests.front();
+			m_requests.pop_front();
+			m_generating = index;
+			lock.unlock();
+			auto chunk = m_generate(index);
+			lock.lock();
+			m_ready[index] = std::move(chunk);
+			m_generating = NOT_GENERATING;
+			m_generated.notify_all();
+		}
+	}
+
+} // End - namespace procgen
+} // End - namespace hungerland
@@ -0,0 +1,192 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+#include <hungerland/rects.h>
+#include <hungerland/map.h>
+
+namespace hungerland {
+namespace rects {
+
+	RectSet RectSet::bake(const map::Map& map, size_t layerId) {
+		RectSet res;
+		res.m_size = map.getMapSize();
+		res.m_rowRects.resize(res.m_size.y);
+		res.bakeArea(map, layerId, 0, 0, int(res.m_size.x) - 1, int(res.m_size.y) - 1);
+		return res;
+	}
+
+	void RectSet::bakeArea(const map::Map& map, size_t layerId, int x0, int y0, int x1, int y1) {
+		x0 = std::max(x0, 0);
+		y0 = std::max(y0, 0);
+		x1 = std::min(x1, int(m_size.x) - 1);
+		y1 = std::min(y1, int(m_size.y) - 1);
+		if(x0 > x1 || y0 > y1) {
+			return;
+		}
+		// Cut rectangles overlapping the area. Those inside of the map are elements of m_rects:
+		std::vector<uint32_t> overlapping;
+		forEachOverlapping(x0, y0, x1, y1, [&](const Rect& r) {
+			overlapping.push_back(uint32_t(&r - m_rects.data()));
+		});
+		for(const auto id : overlapping) {
+			const Rect r = m_rects[id];
+			remove(id);
+			// Parts above and below the area keep their width, parts beside it are on rows of the area:
+			const int rx1 = r.x + r.width - 1;
+			const int ry1 = r.y + r.height - 1;
+			const int my0 = std::max(r.y, y0);
+			const int my1 = std::min(ry1, y1);
+			if(r.y < y0) {
+				add(Rect{r.x, r.y, r.width, y0 - r.y});
+			}
+			if(ry1 > y1) {
+				add(Rect{r.x, y1 + 1, r.width, ry1 - y1});
+			}
+			if(r.x < x0) {
+				add(Rect{r.x, my0, x0 - r.x, my1 - my0 + 1});
+			}
+			if(rx1 > x1) {
+				add(Rect{x1 + 1, my0, rx1 - x1, my1 - my0 + 1});
+			}
+		}
+
+		const int sx = x1 - x0 + 1;
+		const int sy = y1 - y0 + 1;
+		std::vector<uint8_t> isFree(size_t(sx)*size_t(sy), 0); // Empty or already merged
+		for(int y = 0; y < sy; ++y) {
+			for(int x = 0; x < sx; ++x) {
+				isFree[size_t(y)*sx + x] = map.getTileId(layerId, x0 + x, y0 + y) > 0 ? 0 : 1;
+			}
+		}
+		auto isSpanSolid = [&](int x, int y, int width) {
+			const auto* row = &isFree[size_t(y)*sx + x];
+			return std::none_of(row, row + width, [](uint8_t v) { return v != 0; });
+		};
+
+		// Greedy meshing:
+		for(int y = 0; y < sy; ++y) {
+			for(int x = 0; x < sx; ++x) {
+				if(isFree[size_t(y)*sx + x]) {
+					continue;
+				}
+				Rect r{x, y, 1, 1};
+				while(r.x + r.width < sx && isFree[size_t(y)*sx + r.x + r.width] == 0) {
+					++r.width;
+				}
+				while(r.y + r.height < sy && isSpanSolid(r.x, r.y + r.height, r.width)) {
+					++r.height;
+				}
+				for(int ry = r.y; ry < r.y + r.height; ++ry) {
+					std::fill_n(&isFree[size_t(ry)*sx + r.x], r.width, uint8_t(1));
+				}
+				add(Rect{x0 + r.x, y0 + r.y, r.width, r.height});
+				x += r.width - 1;
+			}
+		}
+	}
+
+	void RectSet::scroll(size_t columns) {
+		const int dx = int(std::min(columns, size_t(m_size.x)));
+		// Moving keeps order of rectangles in rows, so only rows of rectangles moved out of the map change:
+		for(uint32_t id = 0; id < m_rects.size(); ++id) {
+			if(m_rects[id].width > 0 && m_rects[id].x + m_rects[id].width <= dx) {
+				remove(id);
+			}
+		}
+		for(auto& r : m_rects) {
+			if(r.width > 0) {
+				r.width -= std::max(dx - r.x, 0);
+				r.x = std::max(r.x - dx, 0);
+			}
+		}
+	}
+
+	void RectSet::add(Rect r) {
+		// Merge with rectangles sharing a whole side, so that cut rectangles grow back together:
+		auto find = [this](int x, int y) -> const uint32_t* {
+			if(y < 0 || y >= int(m_size.y)) {
+				return 0;
+			}
+			const auto& row = m_rowRects[size_t(y)];
+			auto it = std::lower_bound(row.begin(), row.end(), x, [this](uint32_t id, int x) {
+				return m_rects[id].x + m_rects[id].width - 1 < x;
+			});
+			return it != row.end() && m_rects[*it].x <= x ? &*it : 0;
+		};
+		for(bool isMerged = true; isMerged; ) {
+			isMerged = false;
+			const uint32_t* ids[4] = {find(r.x, r.y - 1), find(r.x, r.y + r.height), find(r.x - 1, r.y), find(r.x + r.width, r.y)};
+			for(int side = 0; side < 4 && false == isMerged; ++side) {
+				if(ids[side] == 0) {
+					continue;
+				}
+				const uint32_t id = *ids[side];
+				const Rect n = m_rects[id];
+				const bool isVertical = side < 2 && n.x == r.x && n.width == r.width && (n.y + n.height == r.y || r.y + r.height == n.y);
+				const bool isHorizontal = side >= 2 && n.y == r.y && n.height == r.height;
+				if(isVertical || isHorizontal) {
+					remove(id);
+					const int x1 = std::max(r.x + r.width, n.x + n.width);
+					const int y1 = std::max(r.y + r.height, n.y + n.height);
+					r.x = std::min(r.x, n.x);
+					r.y = std::min(r.y, n.y);
+					r.width = x1 - r.x;
+					r.height = y1 - r.y;
+					isMerged = true;
+				}
+			}
+		}
+
+		uint32_t id = uint32_t(m_rects.size());
+		if(m_freeIds.empty()) {
+			m_rects.push_back(r);
+		} else {
+			id = m_freeIds.back();
+			m_freeIds.pop_back();
+			m_rects[id] = r;
+		}
+		for(int y = r.y; y < r.y + r.height; ++y) {
+			auto& row = m_rowRects[size_t(y)];
+			// Rectangles are mostly added in order of x, so search from the end:
+			auto it = row.end();
+			while(it != row.begin() && m_rects[*(it - 1)].x > r.x) {
+				--it;
+			}
+			row.insert(it, id);
+		}
+	}
+
+	void RectSet::remove(uint32_t id) {
+		const auto& r = m_rects[id];
+		for(int y = r.y; y < r.y + r.height; ++y) {
+			auto& row = m_rowRects[size_t(y)];
+			row.erase(std::lower_bound(row.begin(), row.end(), r.x, [this](uint32_t other, int x) {
+				return m_rects[other].x < x;
+			}));
+		}
+		m_rects[id] = Rect{};
+		m_freeIds.push_back(id);
+	}
+
+} // End - namespace rects
+} // End - namespace hungerland
@@ -64,6 +64,34 @@ namespace texture {
 		setFiltering(false);
 	}
 
+	Texture::Texture(unsigned width, unsigned height, const uint16_t* data) : m_width(width), m_height(height) {
+		// Create texture
+		glGenTextures(1, &m_textureId);
+		checkGLError();
+		// Bind it for use
+		glBindTexture(GL_TEXTURE_2D, m_textureId);
+		checkGLError();
+		// Rows of odd width are not 4 byte aligned:
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, data);
+		checkGLError();
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		// Integer textures can't be filtered
+		setRepeat(false);
+		setFiltering(false);
+	}
+
+	void Texture::update(unsigned x, unsigned y, unsigned width, unsigned height, const uint16_t* data) {
+		assert(x + width <= m_width && y + height <= m_height);
+		glBindTexture(GL_TEXTURE_2D, m_textureId);
+		checkGLError();
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RED_INTEGER, GL_UNSIGNED_SHORT, data);
+		checkGLError();
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
 	Texture::Texture(unsigned width, unsigned height, bool isDepthTexture) : m_width(width), m_height(height) {
 		// Create texture
 		glGenTextures(1, &m_textureId);
@@ -0,0 +1,47 @@
+/*=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+ MIT License
+
+ Copyright (c) 2022 Mikko Romppainen (kajakbros@gmail.com)
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=*/
+///
+/// hungerland_cook: Cooks Tiled map to binary map, which loads without parsing. See hungerland::map::Map::cook.
+/// Usage: hungerland_cook <map.tmx> <map.hlmap>
+/// Image paths are stored as they are loaded, so run in the directory the game loads maps from.
+///
+#include <hungerland/map.h>
+#include <cstdio>
+#include <exception>
+
+int main(int argc, char* argv[]) {
+	if(argc != 3) {
+		printf("Usage: %s <map.tmx> <map%s>\n", argv[0], hungerland::map::Map::COOKED_EXTENSION);
+		return 1;
+	}
+	try {
+		auto map = hungerland::map::loadHeadless<hungerland::map::Map>(argv[1]);
+		map->cook(argv[2]);
+	} catch(const std::exception&) {
+		// Error is already printed by util::ERR
+		printf("Failed to cook map \"%s\"\n", argv[1]);
+		return 1;
+	}
+	return 0;
+}
@@ -1,5 +1,8 @@
 #pragma once
 #include <utils.h>
+#include <assert.h>
+#include <vector>
+#include <algorithm>
 
 namespace apply {
 
@@ -48,6 +51,110 @@ namespace apply {
 		});
 	};
 
+	///
+	/// \brief apply::entitiesParallel Parallel version of apply::entities.
+	/// Entities are partitioned to chunks of grainSize, which are stepped on worker threads.
+	/// Apply function may only read game state and write the entity it is called for.
+	/// Dead entities are removed after all entities have been stepped.
+	///
+	template<typename Jobs, typename GameState, typename Entities, typename DeltaType, typename ApplyFunc>
+	auto entitiesParallel(Jobs& jobs, size_t grainSize, const GameState& game, Entities& entities, DeltaType delta, ApplyFunc apply) {
+		std::vector<char> keep(entities.size(), 1);
+		jobs.parallelFor(0, entities.size(), grainSize, [&](size_t begin, size_t end) {
+			for(auto entityId = begin; entityId<end; ++entityId) {
+				auto& entity = entities[entityId];
+				if(false == entity.isAlive) {
+					keep[entityId] = 0; // Remove agent since it is dead
+					continue;
+				}
+				// Update cooldown
+				entity.coolDownTimer -= delta;
+				if(entity.coolDownTimer < 0) entity.coolDownTimer = 0;
+
+				// Step env:
+				keep[entityId] = apply(game, entities, entityId, delta);
+			}
+		});
+		// Remove killed entities, keeping order of the rest:
+		size_t numAlive = 0;
+		for(auto entityId = 0u; entityId<entities.size(); ++entityId) {
+			if(keep[entityId]) {
+				if(numAlive != entityId) {
+					entities[numAlive] = std::move(entities[entityId]);
+				}
+				++numAlive;
+			}
+		}
+		entities.erase(entities.begin()+numAlive, entities.end());
+	};
+
+	///
+	/// \brief apply::sleepResting Moves entities, which have been at rest for sleepTime, from active entities to sleeping entities.
+	/// Sleeping entities are not stepped until woken.
+	/// \param entities		= Active entities.
+	/// \param sleeping		= Sleeping entities.
+	/// \param delta
+	/// \param sleepTime	= Time entity must be at rest before it falls asleep.
+	/// \param isResting	= f(const Entity&) -> bool. Shall return true, if entity is at rest.
+	/// \return Number of entities put to sleep.
+	///
+	template<typename Entities, typename DeltaType, typename IsRestingFunc>
+	size_t sleepResting(Entities& entities, Entities& sleeping, DeltaType delta, DeltaType sleepTime, IsRestingFunc isResting) {
+		const auto numSleeping = sleeping.size();
+		// Move sleepers out and compact the rest in one pass, keeping order:
+		size_t numActive = 0;
+		for(size_t entityId = 0; entityId<entities.size(); ++entityId) {
+			auto& entity = entities[entityId];
+			entity.restTimer = isResting(entity) ? entity.restTimer + delta : 0;
+			if(entity.isAlive && entity.restTimer >= sleepTime) {
+				sleeping.push_back(std::move(entity));
+				continue;
+			}
+			if(numActive != entityId) {
+				entities[numActive] = std::move(entity);
+			}
+			++numActive;
+		}
+		entities.erase(entities.begin()+numActive, entities.end());
+		return sleeping.size() - numSleeping;
+	};
+
+	///
+	/// \brief apply::wake Moves sleeping entities back to active entities.
+	/// \param entities		= Active entities. Woken entities are appended to the end.
+	/// \param sleeping		= Sleeping entities.
+	/// \param sleepingIds	= Indices of entities to wake in sleeping. May contain duplicates,
+	///						  which are sorted and removed in place.
+	/// \return Number of woken entities.
+	///
+	template<typename Entities, typename Ids>
+	size_t wake(Entities& entities, Entities& sleeping, Ids& sleepingIds) {
+		if(sleepingIds.empty()) {
+			return 0;
+		}
+		std::sort(sleepingIds.begin(), sleepingIds.end());
+		sleepingIds.erase(std::unique(sleepingIds.begin(), sleepingIds.end()), sleepingIds.end());
+		// Move woken entities out and compact the rest in one pass, keeping order:
+		size_t numSleeping = 0;
+		auto id = sleepingIds.begin();
+		for(size_t entityId = 0; entityId<sleeping.size(); ++entityId) {
+			auto& entity = sleeping[entityId];
+			if(id != sleepingIds.end() && size_t(*id) == entityId) {
+				entity.restTimer = 0;
+				entities.push_back(std::move(entity));
+				++id;
+				continue;
+			}
+			if(numSleeping != entityId) {
+				sleeping[numSleeping] = std::move(entity);
+			}
+			++numSleeping;
+		}
+		assert(id == sleepingIds.end());
+		sleeping.erase(sleeping.begin()+numSleeping, sleeping.end());
+		return sleepingIds.size();
+	};
+
 
 } // End - namespace apply
 
@@ -3,8 +3,17 @@
 /// CONTROLLER: Toiminnallisuuden määrittelyt:
 #include <gridsearch.h>
 #include <apply.h> // apply::entities
+#include <pool.h> // pool::Slots
+#include <spatial_hash.h> // spatial_hash::Grid
+#include <joints.h> // joints::solve
+#include <substep.h> // substep::schedule
+#include <rng.h> // rng::Random
+#include <occupancy.h> // occupancy::Grid
 #include <hungerland/map.h>
 #include <hungerland/util.h>
+#include <hungerland/jobs.h>
+#include <hungerland/integrator.h>
+#include <chrono>
 
 namespace tile_map {
 	template<typename Map, typename VecType>
@@ -45,13 +54,24 @@ namespace car_game {
 	///
 	/// \brief game::isGameOver(const GameState&) -> bool
 	/// \param game		= Game state.
-	/// \return true, if some agent winned the game
+	/// \return true, if some agent winned the game by driving into a "finish" object of the map.
+	/// Maps without objects end at x = 261.
 	///
 	template<typename GameState>
 	bool isGameOver(const GameState& game) {
+		const auto& objects = game.tileMap->getObjects();
 		for (size_t i = 0; i < game.agents.size(); ++i) {
 			const auto agent = game.agents[i];
-			if (agent.state.car.position.x > 261.0f) {
+			const auto& pos = agent.state.car.position;
+			bool isFinished = false;
+			if (false == objects.empty()) {
+				objects.forEachAt(glm::vec2(pos.x, pos.y), [&isFinished](const auto& object) {
+					isFinished = isFinished || object.type == "finish";
+				});
+			} else {
+				isFinished = pos.x > 261.0f;
+			}
+			if (isFinished) {
 				printf("Game over %s wins!\n", i==0 ? "Player":"AI");
 				return true;
 			}
@@ -59,6 +79,56 @@ namespace car_game {
 		return false;
 	}
 
+	///
+	/// \brief game::getStateHash(const GameState&) -> uint64_t
+	/// \param game		= Game state.
+	/// \return FNV-1a hash of bits of dynamic entity states.
+	///
+	template<typename GameState>
+	uint64_t getStateHash(const GameState& game) {
+		uint64_t hash = 14695981039346656037ull;
+		auto add = [&hash](const auto& value) {
+			const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+			for(size_t i = 0; i < sizeof(value); ++i) {
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+		};
+		auto addBody = [&add](const auto& body) {
+			add(body.position.x);
+			add(body.position.y);
+			add(body.velocity.x);
+			add(body.velocity.y);
+			add(body.angle);
+		};
+		add(game.totalTime);
+		add(game.numSteps);
+		add(game.random.getState());
+		for(const auto& agent : game.agents) {
+			addBody(agent.state.car);
+			add(agent.state.car.angularVel);
+			addBody(agent.state.trailer);
+			add(agent.state.trailer.angularVel);
+		}
+		for(const auto& item : game.items) {
+			addBody(item.state);
+		}
+		for(const auto& item : game.sleepingItems) {
+			addBody(item.state);
+		}
+		const auto& p = game.projectiles;
+		for(const auto slot : p.getAlive()) {
+			add(slot);
+			add(p.state[slot]);
+			add(p.px[slot]);
+			add(p.py[slot]);
+			add(p.vx[slot]);
+			add(p.vy[slot]);
+			add(p.angle[slot]);
+		}
+		return hash;
+	}
+
 	///
 	/// \brief game::update(GameState& game) -> void
 	/// \param game		= Game state.
@@ -87,17 +157,46 @@ namespace car_game {
 /// - update(GameState& gameState, DeltaType delta) -> const GameState&
 ///
 namespace car_env {
+	///
+	/// \brief car_env::seed Seeds all randomness of the simulation. Same seed and same actions
+	/// give bit identical game states, see game::getStateHash.
+	/// \param game
+	/// \param seed
+	///
+	template<typename GameState>
+	void seed(GameState& game, uint64_t seed) {
+		game.seed = seed;
+		game.random = rng::Random(seed);
+	}
+
+	///
+	/// \brief car_env::resolveLayers Resolves tile layers used by the simulation from their names. Called once
+	/// after the map is loaded, so that code run each frame does not look up layers by name.
+	/// \param game
+	///
+	template<typename GameState>
+	void resolveLayers(GameState& game) {
+		game.layers.road = game.tileMap->getLayerHandle("RoadTiles");
+		game.layers.collision = game.tileMap->getLayerHandle("CollisionLayer");
+	}
+
+	template<typename Body, typename VecType, typename DeltaType>
+	Body stepEuler(Body body, VecType F, VecType I, DeltaType dt) {
+		// Integrate velocity from forces and position from velocity:
+		auto i = dt * F;
+		body.velocity += I + i;
+		body.position += body.velocity * dt;
+		body.angle += body.angularVel * dt;
+		return body;
+	}
+
 	template<typename Body, typename ImpulseFunc, typename ReactFunc, typename VecType, typename DeltaType>
 	auto integrateBody(const Body& oldBody, ImpulseFunc getImpulse, ReactFunc reactFunc, VecType F, VecType I, DeltaType dt) {
 		const VecType ZERO = VecType(0);
-		const float TIME_TOL = 0.005f;
+		// Bisection tolerance follows length of the (sub) step:
+		const float TIME_TOL = std::min(0.005f, 0.3f*float(dt));
 		const auto stepEuler = [&](Body body, DeltaType dt) {
-			// Integrate velocity from forces and position from velocity:
-			auto i = dt * F;
-			body.velocity += I + i;
-			body.position += body.velocity * dt;
-			body.angle += body.angularVel * dt;
-			return body;
+			return car_env::stepEuler(body, F, I, dt);
 		};
 
 		// Run integrator:
@@ -143,9 +242,52 @@ namespace car_env {
 		return b;
 	}
 
+	///
+	/// \brief car_env::integrateBodyScheduled Integrates body with given sub-step plan.
+	/// Body is moved without collision checks, if it can't reach any solid tile during the step.
+	/// Otherwise step is split to plan.steps sub-steps, each integrated with integrateBody.
+	/// \param body
+	/// \param plan		= Sub-step plan of the body.
+	/// \param radius	= Distance of farthest point of the collision shape from body position.
+	/// \param getImpulse
+	/// \param reactFunc
+	/// \param F
+	/// \param I
+	/// \param dt
+	///
+	template<typename Body, typename ImpulseFunc, typename ReactFunc, typename VecType, typename DeltaType>
+	auto integrateBodyScheduled(const Body& body, const substep::Plan& plan, float radius, ImpulseFunc getImpulse, ReactFunc reactFunc, VecType F, VecType I, DeltaType dt) {
+		const auto velocity = body.velocity + I + dt*F;
+		const float travel = (glm::length(velocity) + std::abs(body.angularVel)*radius) * dt;
+		if(travel < plan.clearance) {
+			return stepEuler(body, F, I, dt);
+		}
+		Body b = body;
+		const auto subDt = dt / DeltaType(plan.steps);
+		for(size_t i=0; i<plan.steps; ++i) {
+			b = integrateBody(b, getImpulse, reactFunc, F, I, subDt);
+			I = VecType(0);
+		}
+		return b;
+	}
+
+	///
+	/// \brief getRotationMat
+	/// \param angle
+	/// \return Rotation about z axis. Uses deterministic trigonometry, unlike glm::rotate.
+	///
+	inline glm::mat4 getRotationMat(float angle) {
+		float s, c;
+		hungerland::math::sincos(angle, s, c);
+		glm::mat4 m(1);
+		m[0][0] = c;	m[0][1] = s;
+		m[1][0] = -s;	m[1][1] = c;
+		return m;
+	}
+
 	template<typename Body>
 	auto getRotationMat(const Body& body) {
-		return glm::rotate(glm::mat4(1), body.angle, glm::vec3(0, 0, 1));
+		return getRotationMat(body.angle);
 	}
 
 	template<typename Body>
@@ -187,13 +329,36 @@ namespace car_env {
 	}
 
 	template<typename GameState, typename VecType>
-	auto getTileId(const GameState& game, const std::string layerName, VecType pos) {
-		auto tid = game.tileMap->getTileId(game.tileMap->getLayerIndex(layerName), size_t(pos.x+0.5f), size_t(pos.y + 0.5f));
-		printf("Tileid: %d at <%d, %d>\n", tid, int(pos.x + 0.5f), int(pos.y + 0.5f));
-		return tid;
+	auto getTileId(const GameState& game, typename GameState::LayerHandle layer, VecType pos) {
+		return game.tileMap->getTileId(layer, int(std::floor(pos.x + 0.5f)), int(std::floor(pos.y + 0.5f)));
+	}
+
+	///
+	/// \brief car_env::getSurface
+	/// \param map
+	/// \param layer	= Ground tile layer.
+	/// \param pos		= Map position.
+	/// \return Surface properties of the ground tile at position.
+	///
+	template<typename Map, typename VecType>
+	const auto& getSurface(const Map& map, typename Map::LayerHandle layer, const VecType& pos) {
+		const float x = std::floor(pos.x + 0.5f);
+		const float y = std::floor(pos.y + 0.5f);
+		const int tileId = (x < 0.0f || y < 0.0f) ? 0 : map.getTileId(layer, int(x), int(y));
+		return map.getSurface(tileId);
 	}
 
 
+	///
+	/// \brief car_env::getCollisionHalfSize
+	/// \param body	= Car or trailer body.
+	/// \return Half size of the oriented collision box of the body.
+	///
+	template<typename Body>
+	glm::vec2 getCollisionHalfSize(const Body& body) {
+		return glm::vec2(body.sx/3.0f, body.sy/4.0f);
+	}
+
 	///
 	/// \brief car_env::stepCar
 	/// \param game
@@ -215,23 +380,37 @@ namespace car_env {
 		} else {
 			car.angularVel = 0;
 		}
-		auto irotM = glm::rotate(glm::mat4(1), -car.angle, glm::vec3(0,0,1));
+		// Ground under the car and the trailer:
+		const auto groundLayer = game.layers.road;
+		const auto& carSurface = getSurface(*game.tileMap, groundLayer, car.position);
+		const auto& trailerSurface = getSurface(*game.tileMap, groundLayer, trailer.position);
+
+		auto irotM = getRotationMat(-car.angle);
 		auto vel = irotM * glm::vec4(car.velocity.x, car.velocity.y, 0, 0);
 
-		auto friction = -glm::vec4(0.4f,2.0f,0,1) * vel;
+		auto friction = -carSurface.friction * glm::vec4(0.4f,2.0f,0,1) * vel;
 
+		// Returns contact normal scaled by penetration depth of rotated body against collision tiles.
 		auto collides = [&game](auto& body) {
-			// TODO: Check collision and return impulse
-			auto collisions = game.tileMap->checkCollision("CollisionLayer", glm::vec3(body.position.x, body.position.y, 0), glm::vec3(body.sx/3.0f, body.sy / 4.0f, 0));
-			return getNormalVec<VecType>(collisions);
+			auto contact = game.tileMap->checkCollisionOBB(game.layers.collision, glm::vec2(body.position.x, body.position.y), getCollisionHalfSize(body), body.angle);
+			if(false == contact.hit) {
+				return VecType(0);
+			}
+			// Keep impulse non zero for touching contacts:
+			return std::max(contact.depth, 1e-4f) * VecType(contact.normal.x, contact.normal.y);
 		};
 
 		auto react = [](const auto& oldBody, auto newBody, const VecType& impulse) {
-			// TODO: React body according to impulse
 			if (glm::length(impulse) == 0) {
 				return newBody;
 			}
-			auto newVelocity = 0.8f * glm::reflect(glm::vec3(oldBody.velocity.x, oldBody.velocity.y, 0), glm::vec3(impulse.x, impulse.y, 0));
+			const auto normal = glm::normalize(glm::vec2(impulse.x, impulse.y));
+			const auto oldVelocity = glm::vec2(oldBody.velocity.x, oldBody.velocity.y);
+			if(glm::dot(oldVelocity, normal) >= 0.0f) {
+				// Already moving away from the contact.
+				return newBody;
+			}
+			auto newVelocity = 0.8f * glm::reflect(oldVelocity, normal);
 			newBody.velocity.x = newVelocity.x;
 			newBody.velocity.y = newVelocity.y;
 			return newBody;
@@ -239,40 +418,63 @@ namespace car_env {
 
 		typedef hungerland::map::Map::MapCollision MapCollision;
 
-		// Update player car body:
+		// Apply car forces:
 		{
-			auto rotM = glm::rotate(glm::mat4(1), car.angle, glm::vec3(0, 0, 1));
-			auto gas = 4.0f * glm::vec4(actionId.gas, 0, 0, 0);
+			auto rotM = getRotationMat(car.angle);
+			auto gas = 4.0f * carSurface.speed * glm::vec4(actionId.gas, 0, 0, 0);
 			auto F = rotM * friction + rotM * gas;
-			car = integrateBody(car, collides, react, VecType(F.x, F.y), VecType(0), delta);
+			car.velocity += delta * VecType(F.x, F.y);
 		}
 
-		auto cross = [](const glm::vec4& r, const glm::vec4& f) {
-			return r.x * f.y - r.y * f.x;
-		};
-
-		auto dot = [](const glm::vec4& a, const glm::vec4& b) {
-			return a.x * b.x + a.y * b.y;
-		};
+		// Apply trailer wheel friction:
+		{
+			auto irotT = getRotationMat(-trailer.angle);
+			auto velT = irotT * glm::vec4(trailer.velocity.x, trailer.velocity.y, 0, 0);
+			auto frictionT = -trailerSurface.friction * glm::vec4(0.4f, 2.0f, 0, 1) * velT;
+			auto F = getRotationMat(trailer.angle) * frictionT;
+			trailer.velocity += delta * VecType(F.x, F.y);
+		}
 
-		// Vetokoulun (hitch) paikka mailmassa
+		// Vetokoulu (hitch): Solve joint between car and trailer with warm started sequential impulses.
+		const float CAR_MASS = 1.0f;
+		const float TRAILER_MASS = 0.5f;
+		auto& hitchImpulse = cars[id].state.hitchImpulse;
+		std::array<joints::RevoluteJoint, 1> hitch;
+		hitch[0].bodyA = 0;
+		hitch[0].bodyB = 1;
+		hitch[0].localAnchorA = glm::vec2(-0.5f * car.sx, 0);
+		hitch[0].localAnchorB = glm::vec2(0.5f * trailer.sx, 0);
+		hitch[0].impulse = glm::vec2(hitchImpulse.x, hitchImpulse.y);
 		{
-			auto carMat = getModelMat(car);
-			auto trailerMat = getModelMat(trailer);
-			auto hitchPos = carMat * glm::vec4(-0.5f, 0, 0, 1);
-			auto hitchCoupler = trailerMat * glm::vec4(0.5f, 0, 0, 1);
+			std::array<joints::Body, 2> bodies = { joints::createBody(car, CAR_MASS), joints::createBody(trailer, TRAILER_MASS) };
+			joints::solve(bodies, hitch, 8, delta);
+			joints::applyVelocity(car, bodies[0]);
+			joints::applyVelocity(trailer, bodies[1]);
+			hitchImpulse = VecType(hitch[0].impulse.x, hitch[0].impulse.y);
+		}
 
-			auto fwdCar = getRotationMat(car) * glm::vec4(1.0f, 0, 0, 1);
-			auto fwdTrailer = getRotationMat(trailer) * glm::vec4(1.0f, 0, 0, 1);
+		// Integrate car and trailer bodies:
+		// Sub-step plans are scheduled for all bodies at the start of the update:
+		const size_t planId = 2*size_t(id);
+		const auto carPlan = planId+1 < game.substeps.size() ? game.substeps[planId] : substep::Plan();
+		const auto trailerPlan = planId+1 < game.substeps.size() ? game.substeps[planId+1] : substep::Plan();
+		car = integrateBodyScheduled(car, carPlan, glm::length(getCollisionHalfSize(car)), collides, react, VecType(0), VecType(0), delta);
+		trailer = integrateBodyScheduled(trailer, trailerPlan, glm::length(getCollisionHalfSize(trailer)), collides, react, VecType(0), VecType(0), delta);
 
-			auto F = 150.0f * (hitchPos - hitchCoupler);
-			//float angle = std::atan2(cross(fwdTrailer, fwdTrailer), dot(fwdCar, fwdTrailer));
-			//printf("Trailer pos: <%2.2f, %2.2f>\n", (hitchPos - hitchCoupler).x, (hitchPos - hitchCoupler).y);
-			float torque = cross(glm::normalize(fwdTrailer), F);
-			//printf("torque: %2.2f\n", torque);
-			trailer.angularVel = 0.9f*torque;
-			trailer.velocity *= 0.9f;
-			trailer = integrateBody(trailer, collides, react, VecType(F.x, F.y), VecType(0), delta);
+		// Remove position drift of the hitch, if bodies stay free of collisions:
+		{
+			std::array<joints::Body, 2> bodies = { joints::createBody(car, CAR_MASS), joints::createBody(trailer, TRAILER_MASS) };
+			joints::solvePositions(bodies, hitch, 3);
+			auto newCar = car;
+			auto newTrailer = trailer;
+			newCar.position = VecType(bodies[0].position.x, bodies[0].position.y);
+			newCar.angle = bodies[0].angle;
+			newTrailer.position = VecType(bodies[1].position.x, bodies[1].position.y);
+			newTrailer.angle = bodies[1].angle;
+			if(glm::length(collides(newCar)) == 0 && glm::length(collides(newTrailer)) == 0) {
+				car = newCar;
+				trailer = newTrailer;
+			}
 		}
 
 		return true; // Legal action
@@ -292,55 +494,541 @@ namespace car_env {
 	}
 
 	///
-	/// \brief car_env::stepJuures
+	/// \brief car_env::getJobs
+	/// \return Job system used for parallel entity updates, shared by the whole program.
+	///
+	inline hungerland::jobs::JobSystem& getJobs() {
+		static hungerland::jobs::JobSystem jobs;
+		return jobs;
+	}
+
+	/// Juures projectile states:
+	enum JuuresState {
+		START, TRAILER, FLYING, GROUNDED, DEAD
+	};
+
+	///
+	/// \brief car_env::stepJuures Steps one projectile of pool according to its state.
+	/// Writes only the given slot, so slots can be stepped in parallel. START and DEAD are handled by stepProjectiles.
+	/// \param trailers	= Position (x,y), cos and sin of the angle of each agent trailer.
+	/// \param p		= Projectile pool.
+	/// \param slot
+	/// \param dt
+	///
+	template<typename Pool, typename DeltaType>
+	void stepJuures(const std::vector<glm::vec4>& trailers, Pool& p, uint32_t slot, DeltaType dt) {
+		const float SHED_ACCELERATION = 25.0f;	// Cargo flies off, if trailer accelerates harder.
+		const float FLIGHT_TIME = 0.5f;
+		const float GROUND_TIME = 10.0f;		// Grounded projectiles rot away after this time.
+		p.timer[slot] += dt;
+		switch(p.state[slot]) {
+		case TRAILER: {
+			const auto& trailer = trailers[p.owner[slot]];
+			const float ox = p.ox[slot], oy = p.oy[slot];
+			const auto end = glm::vec2(trailer.x + trailer.z*ox - trailer.w*oy, trailer.y + trailer.w*ox + trailer.z*oy);
+			const auto cur = glm::vec2(p.px[slot], p.py[slot]);
+			const auto v = (end - cur) / dt;
+			const auto a = glm::length(v - glm::vec2(p.vx[slot], p.vy[slot])) / dt;
+			if(a > SHED_ACCELERATION && p.timer[slot] > dt) {
+				// Keep previous velocity and fly off the trailer:
+				p.state[slot] = FLYING;
+				p.timer[slot] = 0.0f;
+				break;
+			}
+			p.px[slot] = end.x;
+			p.py[slot] = end.y;
+			p.vx[slot] = v.x;
+			p.vy[slot] = v.y;
+			p.angle[slot] = hungerland::math::atan2(trailer.w, trailer.z);
+		} break;
+		case FLYING:
+			if(p.timer[slot] >= FLIGHT_TIME) {
+				p.state[slot] = GROUNDED;
+				p.timer[slot] = 0.0f;
+				p.vx[slot] = p.vy[slot] = 0.0f;
+			}
+			break;
+		case GROUNDED:
+			if(p.timer[slot] >= GROUND_TIME) {
+				p.state[slot] = DEAD;
+			}
+			break;
+		default:
+			assert(0);
+			break;
+		}
+	}
+
+	///
+	/// \brief car_env::stepProjectiles Steps all projectiles of the pool.
+	/// \param game
+	/// \param dt
+	///
+	template<typename GameState, typename DeltaType>
+	void stepProjectiles(GameState& game, DeltaType dt) {
+		auto& p = game.projectiles;
+		// Place new projectiles on trailers and despawn dead ones. Iterated backwards, because
+		// despawn moves the last alive slot in place of removed one:
+		const auto& alive = p.getAlive();
+		for(size_t i = alive.size(); i-- > 0; ) {
+			const auto slot = alive[i];
+			if(p.state[slot] == START) {
+				const auto& trailer = game.agents[p.owner[slot]].state.trailer;
+				// Each projectile has its own random numbers, which do not depend on order of updates:
+				rng::Random random(rng::combine(game.seed, game.numSteps, slot));
+				const float x = random.uniform(-0.25f, 0.25f);
+				const auto offset = glm::vec2(x, random.uniform(-0.25f, 0.25f));
+				const auto pos = getRotationMat(trailer) * glm::vec4(offset.x, offset.y, 0.0f, 1.0f);
+				p.ox[slot] = offset.x;
+				p.oy[slot] = offset.y;
+				p.px[slot] = trailer.position.x + pos.x;
+				p.py[slot] = trailer.position.y + pos.y;
+				p.vx[slot] = trailer.velocity.x;
+				p.vy[slot] = trailer.velocity.y;
+				p.state[slot] = TRAILER;
+				p.timer[slot] = 0.0f;
+			} else if(p.state[slot] == DEAD) {
+				p.despawn(slot);
+			}
+		}
+		// Trailer frames are computed once instead of for each cargo:
+		auto& trailers = game.scratch.trailers;
+		trailers.clear();
+		for(const auto& agent : game.agents) {
+			const auto& trailer = agent.state.trailer;
+			float s, c;
+			hungerland::math::sincos(trailer.angle, s, c);
+			trailers.push_back(glm::vec4(trailer.position.x, trailer.position.y, c, s));
+		}
+		// Other states only write their own slot:
+		const size_t GRAIN_SIZE = 1024;
+		getJobs().parallelFor(0, alive.size(), GRAIN_SIZE, [&](size_t begin, size_t end) {
+			for(auto i = begin; i < end; ++i) {
+				stepJuures(trailers, p, alive[i], dt);
+			}
+		});
+	}
+
+	///
+	/// \brief car_env::spawnCargo Spawns projectile on trailer of the owner.
+	/// \return Slot of projectile or pool::Slots::INVALID, if pool is full.
+	///
+	template<typename GameState, typename VisualType>
+	uint32_t spawnCargo(GameState& game, int owner, VisualType visualId) {
+		return game.projectiles.spawn(owner, visualId, START);
+	}
+
+	///
+	/// \brief car_env::integrateEntities Integrates moving entity bodies as one batch.
 	/// \param game
 	/// \param entities
-	/// \param id
+	/// \param isMoving	= f(const Entity&) -> bool. Shall return true, if entity body is integrated.
+	/// \param drag		= Velocity drag coefficient.
 	/// \param dt
-	/// \return
 	///
-	template<typename GameState, typename Entities, typename AgentId, typename DeltaType>
-	bool stepJuures(GameState& game, Entities& entities, AgentId id, DeltaType dt) {
-		enum State {
-			START, TRAILER, FLYING, GROUNDED, DEAD
+	template<typename GameState, typename Entities, typename IsMovingFunc, typename DeltaType>
+	void integrateEntities(GameState& game, Entities& entities, IsMovingFunc isMoving, float drag, DeltaType dt) {
+		auto& bodies = game.scratch.bodies;
+		auto& ids = game.scratch.ids;
+		bodies.clear();
+		ids.clear();
+		for(size_t i=0; i<entities.size(); ++i) {
+			const auto& s = entities[i].state;
+			if(isMoving(entities[i])) {
+				bodies.push(glm::vec2(s.position.x, s.position.y), glm::vec2(s.velocity.x, s.velocity.y));
+				ids.push_back(i);
+			}
+		}
+		const auto mapSize = game.tileMap->getMapSize();
+		hungerland::integrator::Params params;
+		params.drag = drag;
+		params.boundsMax = glm::vec2(float(mapSize.x-1), float(mapSize.y-1));
+		hungerland::integrator::integrate(bodies, params, dt);
+		for(size_t i=0; i<ids.size(); ++i) {
+			auto& s = entities[ids[i]].state;
+			s.position.x = bodies.px[i];
+			s.position.y = bodies.py[i];
+			s.velocity.x = bodies.vx[i];
+			s.velocity.y = bodies.vy[i];
+		}
+	}
+
+	///
+	/// \brief car_env::integrateProjectiles Integrates flying projectiles of the pool as one batch.
+	/// \param game
+	/// \param drag		= Velocity drag coefficient.
+	/// \param dt
+	///
+	template<typename GameState, typename DeltaType>
+	void integrateProjectiles(GameState& game, float drag, DeltaType dt) {
+		auto& bodies = game.scratch.bodies;
+		auto& ids = game.scratch.ids;
+		auto& p = game.projectiles;
+		bodies.clear();
+		ids.clear();
+		for(const auto slot : p.getAlive()) {
+			if(p.state[slot] == FLYING) {
+				bodies.push(glm::vec2(p.px[slot], p.py[slot]), glm::vec2(p.vx[slot], p.vy[slot]));
+				ids.push_back(slot);
+			}
+		}
+		const auto mapSize = game.tileMap->getMapSize();
+		hungerland::integrator::Params params;
+		params.drag = drag;
+		params.boundsMax = glm::vec2(float(mapSize.x-1), float(mapSize.y-1));
+		hungerland::integrator::integrate(bodies, params, dt);
+		for(size_t i=0; i<ids.size(); ++i) {
+			const auto slot = ids[i];
+			p.px[slot] = bodies.px[i];
+			p.py[slot] = bodies.py[i];
+			p.vx[slot] = bodies.vx[i];
+			p.vy[slot] = bodies.vy[i];
+		}
+	}
+
+	///
+	/// \brief car_env::resolveTileCollisions Pushes items and flying projectiles out of collision tiles with one
+	/// batched collision query. Velocity towards the wall is reflected with restitution.
+	/// \param game
+	///
+	template<typename GameState>
+	void resolveTileCollisions(GameState& game) {
+		typedef hungerland::map::Map::BoxQuery BoxQuery;
+		typedef hungerland::map::Map::Contact Contact;
+		const float RESTITUTION = 0.5f;
+		auto& queries = game.scratch.queries;
+		auto& contacts = game.scratch.contacts;
+		queries.clear();
+		auto& items = game.items;
+		auto& p = game.projectiles;
+		for(const auto& item : items) {
+			queries.push_back(BoxQuery{glm::vec2(item.state.position.x, item.state.position.y), 0.5f*glm::vec2(item.state.sx, item.state.sy)});
+		}
+		auto& flying = game.scratch.flying;
+		flying.clear();
+		for(const auto slot : p.getAlive()) {
+			if(p.state[slot] == FLYING) {
+				queries.push_back(BoxQuery{glm::vec2(p.px[slot], p.py[slot]), 0.5f*glm::vec2(p.sx, p.sy)});
+				flying.push_back(slot);
+			}
+		}
+		contacts.resize(queries.size());
+		const auto& map = *game.tileMap;
+		map.checkCollisions(game.layers.collision, queries.data(), queries.size(), contacts.data());
+
+		auto resolve = [RESTITUTION](const Contact& c, float& px, float& py, float& vx, float& vy) {
+			px += c.depth * c.normal.x;
+			py += c.depth * c.normal.y;
+			const float vn = vx*c.normal.x + vy*c.normal.y;
+			if(vn < 0.0f) {
+				vx -= (1.0f + RESTITUTION) * vn * c.normal.x;
+				vy -= (1.0f + RESTITUTION) * vn * c.normal.y;
+			}
 		};
+		for(size_t i=0; i<items.size(); ++i) {
+			if(contacts[i].hit) {
+				auto& s = items[i].state;
+				resolve(contacts[i], s.position.x, s.position.y, s.velocity.x, s.velocity.y);
+			}
+		}
+		for(size_t i=0; i<flying.size(); ++i) {
+			const auto& c = contacts[items.size() + i];
+			if(c.hit) {
+				const auto slot = flying[i];
+				resolve(c, p.px[slot], p.py[slot], p.vx[slot], p.vy[slot]);
+			}
+		}
+	}
+
+	/// Body types in broadphase:
+	enum BodyType {
+		BODY_CAR, BODY_ITEM, BODY_PROJECTILE
+	};
 
-		auto randomVec = [](float r) {
-			return r * (glm::vec2(1.0f) - 2.0f*glm::vec2(float(rand())/float(RAND_MAX),float(rand())/float(RAND_MAX)));
+	/// Contact event ids:
+	enum ContactEvent {
+		CONTACT_CAR_CAR, CONTACT_CAR_ITEM, CONTACT_CAR_PROJECTILE
+	};
+
+	///
+	/// \brief car_env::getRadius
+	/// \param body
+	/// \return Radius of circle bounding the body.
+	///
+	template<typename Body>
+	float getRadius(const Body& body) {
+		return 0.5f * std::max(body.sx, body.sy);
+	}
+
+	///
+	/// \brief car_env::buildBroadphase Inserts cars, items and projectiles to game broadphase grid.
+	/// \param game
+	///
+	template<typename GameState>
+	void buildBroadphase(GameState& game) {
+		auto& grid = game.broadphase;
+		grid.clear();
+		for(uint32_t i=0; i<game.agents.size(); ++i) {
+			const auto& car = game.agents[i].state.car;
+			grid.insert(BODY_CAR, i, car.position.x, car.position.y, getRadius(car));
+		}
+		for(uint32_t i=0; i<game.items.size(); ++i) {
+			const auto& item = game.items[i].state;
+			grid.insert(BODY_ITEM, i, item.position.x, item.position.y, getRadius(item));
+		}
+		const auto& p = game.projectiles;
+		const float projectileRadius = 0.5f * std::max(p.sx, p.sy);
+		for(const auto slot : p.getAlive()) {
+			// Cargo on trailers moves with its trailer and is not tested separately:
+			if(p.state[slot] == FLYING || p.state[slot] == GROUNDED) {
+				grid.insert(BODY_PROJECTILE, slot, p.px[slot], p.py[slot], projectileRadius);
+			}
+		}
+		grid.build();
+	}
+
+	///
+	/// \brief car_env::updateOccupancy Moves cars and trailers, which have crossed a tile boundary, in the occupancy grid.
+	/// \param game
+	///
+	template<typename GameState>
+	void updateOccupancy(GameState& game) {
+		const auto mapSize = game.tileMap->getMapSize();
+		if(game.occupancy.getWidth() != mapSize.x || game.occupancy.getHeight() != mapSize.y) {
+			game.occupancy = occupancy::Grid(mapSize.x, mapSize.y);
+		}
+		for(uint32_t i=0; i<game.agents.size(); ++i) {
+			const auto& state = game.agents[i].state;
+			game.occupancy.update(2*i, state.car.position.x, state.car.position.y);
+			game.occupancy.update(2*i+1, state.trailer.position.x, state.trailer.position.y);
+		}
+	}
+
+	///
+	/// \brief car_env::findContacts Finds car contacts from broadphase and tests them with sphere-sphere test.
+	/// Only cars collide, so broadphase is queried around each car instead of testing all pairs of cells.
+	/// This keeps the cost low when lots of items and projectiles pile up in the same cells.
+	/// Cars are tile sized, so car pairs are found from neighbour cells of the occupancy grid.
+	/// \param game
+	/// \param events = Contact events are added here. Sender is always the car.
+	///
+	template<typename GameState, typename Events>
+	void findContacts(const GameState& game, Events& events) {
+		typedef typename Events::value_type Event;
+		for(uint32_t carId=0; carId<game.agents.size(); ++carId) {
+			const auto& body = game.agents[carId].state.car;
+			const spatial_hash::Entry car{BODY_CAR, carId, body.position.x, body.position.y, getRadius(body)};
+			const int reach = int(std::ceil(2.0f*car.r));
+			game.occupancy.forNeighbours(car.x, car.y, reach, [&](uint32_t bodyId) {
+				const uint32_t otherId = bodyId / 2;
+				if(bodyId % 2 != 0 || otherId <= carId) {
+					return; // Trailer, self or pair reported already
+				}
+				const auto& otherBody = game.agents[otherId].state.car;
+				const spatial_hash::Entry other{BODY_CAR, otherId, otherBody.position.x, otherBody.position.y, getRadius(otherBody)};
+				if(utils::isCollisionSphereSphere(car, other, car.r, other.r)) {
+					Event e;
+					e.id = CONTACT_CAR_CAR;
+					e.sender = car.id;
+					e.receiver = other.id;
+					events.push_back(e);
+				}
+			});
+			game.broadphase.queryRadius(car.x, car.y, car.r, [&](const spatial_hash::Entry& other) {
+				if(other.type == BODY_CAR) {
+					return; // Found from occupancy grid
+				}
+				if(other.type == BODY_PROJECTILE && game.projectiles.owner[other.id] == int(car.id)) {
+					return; // Own cargo
+				}
+				if(false == utils::isCollisionSphereSphere(car, other, car.r, other.r)) {
+					return;
+				}
+				Event e;
+				e.id = other.type == BODY_ITEM ? CONTACT_CAR_ITEM : CONTACT_CAR_PROJECTILE;
+				e.sender = car.id;
+				e.receiver = other.id;
+				events.push_back(e);
+			});
+		}
+	}
+
+	///
+	/// \brief car_env::selectTargets Sets target of each agent to nearest other car within given radius.
+	/// \param game
+	/// \param radius
+	///
+	template<typename GameState>
+	void selectTargets(GameState& game, float radius) {
+		for(size_t agentId=0; agentId<game.agents.size(); ++agentId) {
+			auto& agent = game.agents[agentId].state;
+			const auto& pos = agent.car.position;
+			float minDist = radius*radius;
+			game.broadphase.queryRadius(pos.x, pos.y, radius, [&](const spatial_hash::Entry& e) {
+				if(e.type != BODY_CAR || e.id == agentId) {
+					return;
+				}
+				const auto d = (e.x-pos.x)*(e.x-pos.x) + (e.y-pos.y)*(e.y-pos.y);
+				if(d <= minDist) {
+					minDist = d;
+					agent.targetId = e.id;
+				}
+			});
+		}
+	}
+
+	///
+	/// \brief car_env::isResting
+	/// \param entity	= Item entity.
+	/// \return true, if entity body is slower than rest speed and may fall asleep.
+	///
+	template<typename Entity>
+	bool isResting(const Entity& entity) {
+		const float REST_SPEED = 0.05f;
+		const auto& v = entity.state.velocity;
+		return v.x*v.x + v.y*v.y < REST_SPEED*REST_SPEED;
+	}
+
+	///
+	/// \brief car_env::buildSleepingBroadphase Inserts sleeping items to sleeping broadphase grid,
+	/// if sleeping entities have changed since the last build.
+	/// \param game
+	///
+	template<typename GameState>
+	void buildSleepingBroadphase(GameState& game) {
+		if(false == game.sleepingChanged) {
+			return;
+		}
+		auto& grid = game.sleepingBroadphase;
+		grid.clear();
+		for(uint32_t i=0; i<game.sleepingItems.size(); ++i) {
+			const auto& item = game.sleepingItems[i].state;
+			grid.insert(BODY_ITEM, i, item.position.x, item.position.y, getRadius(item));
+		}
+		grid.build();
+		game.sleepingChanged = false;
+	}
+
+	///
+	/// \brief car_env::wakeRadius Wakes sleeping items overlapping circle at x,y with radius r.
+	/// Shall be called before applying an impulse to sleeping bodies in the area.
+	/// \param game
+	/// \return Number of woken entities.
+	///
+	template<typename GameState>
+	size_t wakeRadius(GameState& game, float x, float y, float r) {
+		buildSleepingBroadphase(game);
+		auto& itemIds = game.scratch.wakeIds;
+		itemIds.clear();
+		game.sleepingBroadphase.queryRadius(x, y, r, [&](const spatial_hash::Entry& e) {
+			itemIds.push_back(e.id);
+		});
+		const auto numWoken = apply::wake(game.items, game.sleepingItems, itemIds);
+		game.sleepingChanged |= numWoken > 0;
+		return numWoken;
+	}
+
+	///
+	/// \brief car_env::wakeTouched Wakes sleeping items touched by cars, moving items or flying projectiles.
+	/// Cost depends on number of active bodies only.
+	/// \param game
+	///
+	template<typename GameState>
+	void wakeTouched(GameState& game) {
+		if(game.sleepingItems.empty()) {
+			return;
+		}
+		buildSleepingBroadphase(game);
+		auto& itemIds = game.scratch.wakeIds;
+		itemIds.clear();
+		auto queryCircle = [&](float x, float y, float r) {
+			game.sleepingBroadphase.queryRadius(x, y, r, [&](const spatial_hash::Entry& e) {
+				itemIds.push_back(e.id);
+			});
+		};
+		auto query = [&](const auto& body) {
+			queryCircle(body.position.x, body.position.y, getRadius(body));
 		};
+		for(const auto& agent : game.agents) {
+			query(agent.state.car);
+			query(agent.state.trailer);
+		}
+		// Resting bodies do not wake others, otherwise neighbours would keep each other awake:
+		for(const auto& item : game.items) {
+			if(item.restTimer <= 0) query(item.state);
+		}
+		const auto& p = game.projectiles;
+		for(const auto slot : p.getAlive()) {
+			if(p.state[slot] == FLYING) queryCircle(p.px[slot], p.py[slot], 0.5f * std::max(p.sx, p.sy));
+		}
+		const auto numWoken = apply::wake(game.items, game.sleepingItems, itemIds);
+		game.sleepingChanged |= numWoken > 0;
+	}
 
-		auto& e = entities[id];
-		auto& s = e.state;
-		const auto& owner = game.agents[s.owner].state;
-
-		if(s.state == START) {
-			s.offset = randomVec(0.25f);
-			auto pos = getRotationMat(owner.trailer) * glm::vec4(s.offset.x,s.offset.y,0.0f,1.0f);
-			s.position.x = owner.trailer.position.x+pos.x;
-			s.position.y = owner.trailer.position.y+pos.y;
-			s.state = TRAILER;
-		} else if(TRAILER) {
-			auto endPos = getRotationMat(owner.trailer) * glm::vec4(s.offset.x,s.offset.y,0.0f,1.0f);
-			auto end = glm::vec2(owner.trailer.position.x+endPos.x,owner.trailer.position.y+endPos.y);
-			auto cur = s.position;
-			auto d = glm::length(end-cur);
-			auto v = (end-cur)/dt;
-			auto dv = glm::length(v-s.velocity);
-			auto a = dv/dt;
-			//printf("d=%2.3f, v=%2.3f, dv=%2.3f, a=%2.3f\n", d, glm::length(v), dv, a);
-			//auto vel = d;
-
-
-			s.position.x = owner.trailer.position.x+endPos.x;
-			s.position.y = owner.trailer.position.y+endPos.y;
-			s.velocity = v;
-		} else if(FLYING) {
-		} else if(GROUNDED) {
-		} else if(DEAD) {
-		} else {
-			assert(0);
+	///
+	/// \brief car_env::scheduleSubsteps Chooses number of integration sub-steps for each car and trailer.
+	/// Fast bodies near walls get more sub-steps, bodies far from walls are moved without collision checks.
+	/// Plans are stored to game.substeps, two for each agent (car, trailer).
+	/// \param game
+	/// \param dt
+	///
+	template<typename GameState, typename DeltaType>
+	void scheduleSubsteps(GameState& game, DeltaType dt) {
+		const float MIN_STEP_LENGTH = 0.1f;	// Tiles
+		const size_t MAX_STEPS = 8;			// Per body
+		const size_t BUDGET = 64;			// For all bodies in one update
+		auto& requests = game.scratch.requests;
+		requests.clear();
+		const auto& field = game.tileMap->getClearance(game.layers.collision);
+		auto addRequest = [&](const auto& body) {
+			const float radius = glm::length(getCollisionHalfSize(body));
+			substep::Request r;
+			r.travel = (glm::length(body.velocity) + std::abs(body.angularVel)*radius) * dt;
+			r.clearance = std::max(0.0f, field.getClearance(body.position.x, body.position.y) - radius);
+			requests.push_back(r);
+		};
+		for(const auto& agent : game.agents) {
+			addRequest(agent.state.car);
+			addRequest(agent.state.trailer);
 		}
-		return true;
+		substep::schedule(requests, game.substeps, MIN_STEP_LENGTH, MAX_STEPS, std::max(BUDGET, requests.size()));
+	}
+
+	///
+	/// \brief car_env::updateSensors Casts ray sensors of all agents against walls and road edges.
+	/// \param game
+	///
+	template<typename GameState>
+	void updateSensors(GameState& game) {
+		const float MAX_DISTANCE = 8.0f; // Tiles
+		auto& origins = game.scratch.origins;
+		auto& headings = game.scratch.headings;
+		auto& hits = game.scratch.hits;
+		auto& sensors = game.sensors;
+		if(sensors.angles.empty()) {
+			const float PI = 3.14159265f;
+			sensors.angles = { -PI/2, -PI/3, -PI/6, 0.0f, PI/6, PI/3, PI/2 };
+		}
+		origins.clear();
+		headings.clear();
+		for(const auto& agent : game.agents) {
+			const auto& car = agent.state.car;
+			origins.push_back(glm::vec2(car.position.x, car.position.y));
+			headings.push_back(car.angle);
+		}
+		const auto numRays = sensors.angles.size();
+		hits.resize(origins.size() * numRays);
+		auto cast = [&](auto layer, bool hitEmpty, std::vector<float>& distances) {
+			const auto& map = *game.tileMap;
+			map.raycastSensors(layer, origins.data(), headings.data(), origins.size(),
+				sensors.angles.data(), numRays, MAX_DISTANCE, hits.data(), hitEmpty);
+			distances.resize(hits.size());
+			for(size_t i=0; i<hits.size(); ++i) {
+				distances[i] = hits[i].distance;
+			}
+		};
+		cast(game.layers.collision, false, sensors.walls);
+		cast(game.layers.road, true, sensors.roadEdges);
 	}
 
 	///
@@ -351,21 +1039,74 @@ namespace car_env {
 	///
 	template<typename GameState, typename AgentId, typename ActionId, typename Events, typename VecType, typename DeltaType>
 	const GameState& update(GameState& game, DeltaType delta) {
+		++game.numSteps;
 		game.totalTime += delta;
 		if (game.totalTime >= 4.0f) {
 			game.isRunning = true;
 		}
 		// Functions to use:
 		auto stepCar		= car_env::stepCar<GameState, decltype(game.agents), AgentId, ActionId, VecType, DeltaType>;
-		auto stepItem	= car_env::stepNull<GameState, decltype(game.items), AgentId, DeltaType>;
-		auto stepProjectile	= car_env::stepJuures<GameState, decltype(game.projectiles), AgentId, DeltaType>;
-		// Run updates for entities:
-		apply::agents(game, game.agents, delta, -1, stepCar);
-		apply::entities(game, game.items, delta, stepItem);
-		apply::entities(game, game.projectiles, delta, stepProjectile);
-
-		// TODO: Check (collision) events:
+		auto stepItem	= car_env::stepNull<const GameState, decltype(game.items), size_t, DeltaType>;
+		// Timing of update phases:
+		typedef std::chrono::steady_clock Clock;
+		auto seconds = [](Clock::time_point t0, Clock::time_point t1) {
+			return std::chrono::duration<double>(t1 - t0).count();
+		};
+		double carTime = 0;
+		auto timedStepCar = [&](auto& state, auto& cars, auto id, auto actionId, auto dt) {
+			const auto t0 = Clock::now();
+			const auto res = stepCar(state, cars, id, actionId, dt);
+			carTime += seconds(t0, Clock::now());
+			return res;
+		};
+
+		// Run updates for entities. Each phase adds its time to the timings:
+		auto t0 = Clock::now();
+		auto lap = [&](double& timing) {
+			const auto t1 = Clock::now();
+			timing += seconds(t0, t1);
+			t0 = t1;
+		};
+		scheduleSubsteps(game, delta);
+		lap(game.timings.substeps);
+		updateSensors(game);
+		lap(game.timings.sensors);
+		apply::agents(game, game.agents, delta, -1, timedStepCar);
+		lap(game.timings.policy);
+		game.timings.policy -= carTime;
+		game.timings.cars += carTime;
+		updateOccupancy(game);
+		lap(game.timings.occupancy);
+		// Items only read the game state, so those can be stepped in parallel:
+		const size_t GRAIN_SIZE = 256;
+		apply::entitiesParallel(getJobs(), GRAIN_SIZE, game, game.items, delta, stepItem);
+		// Integrate free moving bodies:
+		const float DRAG = 1.5f;
+		// Items at rest stay in place, so only moving items are integrated:
+		integrateEntities(game, game.items, [](const auto& item) {
+			return item.state.velocity.x != 0.0f || item.state.velocity.y != 0.0f;
+		}, DRAG, delta);
+		lap(game.timings.items);
+		stepProjectiles(game, delta);
+		integrateProjectiles(game, DRAG, delta);
+		lap(game.timings.projectiles);
+		resolveTileCollisions(game);
+		lap(game.timings.tiles);
+		// Put resting items to sleep:
+		const float SLEEP_TIME = 0.5f;
+		const size_t numSlept = apply::sleepResting(game.items, game.sleepingItems, delta, SLEEP_TIME, [](const auto& e) {
+			return isResting(e);
+		});
+		game.sleepingChanged |= numSlept > 0;
+		lap(game.timings.sleeping);
+
+		// Check collision events:
 		Events evs;
+		wakeTouched(game);
+		buildBroadphase(game);
+		findContacts(game, evs);
+		selectTargets(game, 10.0f);
+		lap(game.timings.contacts);
 
 		// Update game logic
 		car_game::update(game, evs);
@@ -374,6 +1115,52 @@ namespace car_env {
 } // End - namespace car_env
 
 namespace car_ai {
+	///
+	/// \brief sensorDriver Steers towards direction with most free road, preferring direction of the goal.
+	/// Uses ray sensors of the game state and distance fields of the map instead of path search.
+	/// \param agentId
+	/// \param gameState
+	/// \return
+	///
+	template<typename Action, typename EventType, typename AgentId, typename GameState>
+	Action sensorDriver(AgentId agentId, const GameState& gameState) {
+		const auto& sensors = gameState.sensors;
+		const auto numRays = sensors.angles.size();
+		if(false == gameState.isRunning || sensors.walls.size() < (size_t(agentId)+1)*numRays) {
+			return Action{0, 0};
+		}
+		const auto& car = gameState.agents[agentId].state.car;
+		const auto d = gameState.goals[0].state - car.position;
+		const float goalAngle = hungerland::math::atan2(d.y, d.x) - car.angle;
+		// Near walls or road edges, prefer directions away from them along gradients of the distance fields:
+		const auto& map = *gameState.tileMap;
+		const auto& walls = map.getClearance(gameState.layers.collision);
+		const auto& road = map.getClearance(gameState.layers.road);
+		const float wallWeight = std::max(0.0f, 1.5f - walls.sample(car.position.x, car.position.y));
+		const float roadWeight = std::max(0.0f, 1.0f + road.sample(car.position.x, car.position.y));
+		const glm::vec2 away = wallWeight*walls.getGradient(car.position.x, car.position.y)
+			- roadWeight*road.getGradient(car.position.x, car.position.y);
+		float bestScore = -1e9f;
+		float bestAngle = 0.0f;
+		float forwardFree = 0.0f;
+		for(size_t k=0; k<numRays; ++k) {
+			const auto i = agentId*numRays + k;
+			const float free = std::min(sensors.walls[i], sensors.roadEdges[i]);
+			const float rayAngle = car.angle + sensors.angles[k];
+			const float score = free + 2.0f*hungerland::math::cos(sensors.angles[k] - goalAngle)
+				+ 2.0f*glm::dot(away, glm::vec2(hungerland::math::cos(rayAngle), hungerland::math::sin(rayAngle)));
+			if(score > bestScore) {
+				bestScore = score;
+				bestAngle = sensors.angles[k];
+			}
+			if(sensors.angles[k] == 0.0f) {
+				forwardFree = free;
+			}
+		}
+		const int steer = bestAngle > 0.1f ? 1 : (bestAngle < -0.1f ? -1 : 0);
+		return Action{ forwardFree > 1.0f || steer == 0 ? 1 : 0, steer };
+	}
+
 	///
 	/// \brief plannerDriver
 	/// \param agentId
@@ -389,14 +1176,24 @@ namespace car_ai {
 		const auto& map = *gameState.tileMap;
 		auto agentPos = gameState.agents[agentId].state.car.position;
 		auto& car = gameState.agents[agentId].state.car;
-		auto isLegalState = [&map](const auto& pos) {
-			auto roadTileId = map.getTileId(map.getLayerIndex("RoadTiles"), pos.x, pos.y);
-			auto collisionTileId = map.getTileId(map.getLayerIndex("CollisionLayer"), pos.x, pos.y);
+		const auto layers = gameState.layers;
+		auto isLegalState = [&map, layers](const auto& pos) {
+			auto roadTileId = map.getTileId(layers.road, pos.x, pos.y);
+			auto collisionTileId = map.getTileId(layers.collision, pos.x, pos.y);
 			return roadTileId > 0 && collisionTileId == 0;
 		};
 
+		// Cells occupied by other cars and trailers are legal, but expensive to drive through:
+		const float OCCUPIED_COST = 5.0f;
+		auto getStepCost = [&gameState, agentId, OCCUPIED_COST](const auto& pos) {
+			const bool occupied = gameState.occupancy.isOccupied(pos.x, pos.y, [agentId](uint32_t bodyId) {
+				return bodyId / 2 == uint32_t(agentId); // Own car and trailer
+			});
+			return occupied ? OCCUPIED_COST : 1.0f;
+		};
+
 		if (gameState.isRunning) {
-			std::vector<glm::vec2> waypoints = gridsearch::searchWaypoints(agentPos, gameState.goals[0].state, isLegalState, 90);
+			std::vector<glm::vec2> waypoints = gridsearch::searchWaypoints(agentPos, gameState.goals[0].state, isLegalState, getStepCost, 90);
 			if (waypoints.size() < 7) {
 				hungerland::util::WARN("AI could not find waypoints!\n");
 				return Action{ 0, 0 };
@@ -411,7 +1208,9 @@ namespace car_ai {
 
 			int steer = 1.0;
 			if (std::abs(cr) < 0.5f) steer = 0;
-			return Action{ rand() % ((2+ gameState.aiDifficulty)-agentId) != 0, cr < 0 ? -steer : +steer };
+			// Policy can't change the game state, so random numbers come from the seed, step and agent:
+			rng::Random random(rng::combine(gameState.seed, gameState.numSteps, uint64_t(agentId)));
+			return Action{ random.below(uint32_t((2+ gameState.aiDifficulty)-agentId)) != 0, cr < 0 ? -steer : +steer };
 		}
 		else {
 			return Action{0, 0};
@@ -0,0 +1,468 @@
+#pragma once
+///
+/// ENDLESS: Loputon kaupunkirata, joka generoidaan siemenestä ajon aikana.
+/// - car_endless::getMainRow(seed, chunk, height) -> int
+/// - car_endless::paintTile(isHorizontal, edges, variant, pixels) -> void
+/// - car_endless::generateChunk(wangTiles, seed, chunk, height) -> Chunk
+/// - car_endless::Track
+///
+/// Kartta on kiinteän kokoinen ikkuna loputtomaan rataan. Rata koostuu CHUNK_WIDTH levyisistä
+/// paloista, jotka taustasäie generoi johtavan auton edelle. Kun johtava auto lähestyy kartan
+/// oikeaa reunaa, kartta ja kaikki entiteetit siirretään yhden palan verran vasemmalle ja
+/// uusi pala kirjoitetaan oikeaan reunaan. Muisti ei siis kasva radan pituuden mukana.
+#include <rng.h> // rng::combine
+#include <hungerland/map.h>
+#include <hungerland/procgen.h>
+#include <hungerland/util.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace car_endless {
+	static constexpr int SIDE = 16;				// Length of the short side of Wang tiles in map tiles
+	static constexpr int CHUNK_WIDTH = 2*SIDE;	// Width of generated chunks in map tiles
+	static constexpr int ROAD = SIDE/2 - 1;		// First row or column of roads in Wang tiles. Roads are two tiles wide.
+	static constexpr int NUM_STYLES = 5;		// Roof styles of buildings in Buildings_tileset
+
+	///
+	/// \brief The Cell enum. Content of a generated cell as bits.
+	///
+	enum Cell : uint8_t {
+		ROAD_H		= 1,	// Horizontal road
+		ROAD_V		= 2,	// Vertical road, both bits at crossings
+		BUILDING	= 4,	// Solid building, roof style in high bits
+		STYLE_SHIFT	= 4,
+	};
+
+	///
+	/// \brief The Layer enum. Tile layers of a generated chunk.
+	///
+	enum Layer {
+		BACKGROUND = 0,		// Sidewalks around roads, layer "RoadBG"
+		ROADS,				// Drivable road, layer "RoadTiles"
+		COLLISION,			// Buildings, layer "CollisionLayer"
+		NUM_LAYERS,
+	};
+
+	// Global tile ids of Road_tileset (firstgid 1) and Buildings_tileset (firstgid 257):
+	static constexpr int SIDEWALK_TILE	= 73;	// 4x4 sidewalk pattern
+	static constexpr int ROAD_H_TILE	= 93;	// 4x2 horizontal road
+	static constexpr int ROAD_V_TILE	= 14;	// 2x4 vertical road
+	static constexpr int CROSSING_TILE	= 26;	// 2x2 crossing
+	static constexpr int BUILDING_TILE	= 257;	// 3x3 roof of first style, next style starts 3 tiles to the right
+	static constexpr int TILESET_COLUMNS = 16;
+
+	///
+	/// \brief getMainRow
+	/// \param seed		= Seed of the track.
+	/// \param chunk	= Index of the chunk from the start of the track.
+	/// \param height	= Height of the map in tiles.
+	/// \return First row of the main road of the chunk. Main road goes through every chunk, so the track never ends.
+	///
+	inline int getMainRow(uint64_t seed, int64_t chunk, int height) {
+		const auto numRows = uint64_t(std::max(height / SIDE, 1));
+		return SIDE * int(rng::combine(seed, uint64_t(chunk), 1) % numRows) + ROAD;
+	}
+
+	///
+	/// \brief paintTile Paints a herringbone Wang tile of city blocks, see hungerland::procgen::WangTiles.
+	/// Edge color 1 means that a road crosses the middle of the edge. Roads of the tile are joined along
+	/// the long axis of the tile, and the rest is filled with buildings one tile away from roads and edges.
+	///
+	inline void paintTile(bool isHorizontal, const int* edges, uint32_t variant, uint8_t* pixels) {
+		const int w = isHorizontal ? 2*SIDE : SIDE;
+		const int h = isHorizontal ? SIDE : 2*SIDE;
+		auto paint = [&](int x0, int y0, int x1, int y1, uint8_t cell) {
+			for(int y = std::max(y0, 0); y <= std::min(y1, h-1); ++y) {
+				for(int x = std::max(x0, 0); x <= std::min(x1, w-1); ++x) {
+					pixels[y*w + x] |= cell;
+				}
+			}
+		};
+		// Edges as start of the road on the edge and its direction inwards:
+		struct Port {
+			int x, y;
+			bool isVertical;
+		};
+		const Port horizontalPorts[6] = {
+			{ROAD, 0, true}, {SIDE+ROAD, 0, true}, {0, ROAD, false}, {w-1, ROAD, false}, {ROAD, h-1, true}, {SIDE+ROAD, h-1, true},
+		};
+		const Port verticalPorts[6] = {
+			{ROAD, 0, true}, {0, ROAD, false}, {w-1, ROAD, false}, {0, SIDE+ROAD, false}, {w-1, SIDE+ROAD, false}, {ROAD, h-1, true},
+		};
+		const auto* ports = isHorizontal ? horizontalPorts : verticalPorts;
+		// Hub road along the long axis covers the middle of the tile and all roads of the edges:
+		int hubMin = (isHorizontal ? w : h)/2 - 1;
+		int hubMax = hubMin + 1;
+		bool hasRoads = false;
+		for(int i = 0; i < hungerland::procgen::WangTiles::NUM_EDGES; ++i) {
+			if(edges[i] == 0) {
+				continue;
+			}
+			hasRoads = true;
+			const auto& p = ports[i];
+			const int along = isHorizontal ? p.x : p.y;
+			hubMin = std::min(hubMin, along);
+			hubMax = std::max(hubMax, along + (p.isVertical == isHorizontal ? 1 : 0));
+			if(isHorizontal && p.isVertical) {
+				paint(p.x, std::min(p.y, ROAD), p.x+1, std::max(p.y, ROAD+1), ROAD_V);
+			} else if(false == isHorizontal && false == p.isVertical) {
+				paint(std::min(p.x, ROAD), p.y, std::max(p.x, ROAD+1), p.y+1, ROAD_H);
+			}
+		}
+		if(hasRoads) {
+			if(isHorizontal) {
+				paint(hubMin, ROAD, hubMax, ROAD+1, ROAD_H);
+			} else {
+				paint(ROAD, hubMin, ROAD+1, hubMax, ROAD_V);
+			}
+		}
+		// Buildings:
+		const uint8_t building = uint8_t(BUILDING | ((variant % NUM_STYLES) << STYLE_SHIFT));
+		for(int y = 1; y < h-1; ++y) {
+			for(int x = 1; x < w-1; ++x) {
+				bool isNearRoad = false;
+				for(int ny = y-1; ny <= y+1; ++ny) {
+					for(int nx = x-1; nx <= x+1; ++nx) {
+						isNearRoad = isNearRoad || (pixels[ny*w + nx] & (ROAD_H | ROAD_V)) != 0;
+					}
+				}
+				if(false == isNearRoad) {
+					pixels[y*w + x] = building;
+				}
+			}
+		}
+	}
+
+	///
+	/// \brief generateChunk Generates tiles of a chunk of the track. Depends only on the seed and the chunk index,
+	/// so chunks can be generated in any order and on any thread.
+	/// \param wangTiles	= City blocks painted with paintTile.
+	/// \param seed		= Seed of the track.
+	/// \param chunk		= Index of the chunk from the start of the track.
+	/// \param height		= Height of the map in tiles.
+	/// \return Tiles of each Layer. Failure of wangTiles to generate the chunk is an error, see util::ERR.
+	///
+	inline hungerland::procgen::ChunkGenerator::Chunk generateChunk(const hungerland::procgen::WangTiles& wangTiles, uint64_t seed, int64_t chunk, int height) {
+		const int w = CHUNK_WIDTH;
+		const int h = height;
+		std::vector<uint8_t> cells(size_t(w*h), 0);
+		if(false == wangTiles.generate(rng::combine(seed, uint64_t(chunk)), w, h, cells.data())) {
+			hungerland::util::ERR("Failed to generate Wang tiles of chunk " + std::to_string(chunk));
+		}
+		auto at = [&](int x, int y) -> uint8_t {
+			return (x < 0 || y < 0 || x >= w || y >= h) ? 0 : cells[size_t(y*w + x)];
+		};
+		auto paint = [&](int x0, int y0, int x1, int y1, uint8_t cell) {
+			for(int y = y0; y <= y1; ++y) {
+				for(int x = x0; x <= x1; ++x) {
+					cells[size_t(y*w + x)] = uint8_t((cells[size_t(y*w + x)] & (ROAD_H | ROAD_V)) | cell);
+				}
+			}
+		};
+
+		// Main road continues from the row of the previous chunk and turns to the row of this chunk.
+		// Roads of separately generated Wang patterns do not join at chunk boundaries, but main road always does.
+		const int fromRow = getMainRow(seed, chunk - 1, h);
+		const int toRow = getMainRow(seed, chunk, h);
+		paint(0, fromRow, ROAD+1, fromRow+1, ROAD_H);
+		paint(ROAD, std::min(fromRow, toRow), ROAD+1, std::max(fromRow, toRow)+1, ROAD_V);
+		paint(ROAD, toRow, w-1, toRow+1, ROAD_H);
+
+		// Remove buildings next to the main road, and thin slices of buildings left by it:
+		auto isBuilding = [&](int x, int y) {
+			return (at(x, y) & BUILDING) != 0;
+		};
+		for(int y = 0; y < h; ++y) {
+			for(int x = 0; x < w; ++x) {
+				bool isNearRoad = false;
+				for(int ny = y-1; ny <= y+1; ++ny) {
+					for(int nx = x-1; nx <= x+1; ++nx) {
+						isNearRoad = isNearRoad || (at(nx, ny) & (ROAD_H | ROAD_V)) != 0;
+					}
+				}
+				if(isNearRoad) {
+					cells[size_t(y*w + x)] &= (ROAD_H | ROAD_V);
+				}
+			}
+		}
+		for(bool isChanged = true; isChanged; ) {
+			isChanged = false;
+			for(int y = 0; y < h; ++y) {
+				for(int x = 0; x < w; ++x) {
+					const bool isThin = (false == isBuilding(x-1, y) && false == isBuilding(x+1, y))
+						|| (false == isBuilding(x, y-1) && false == isBuilding(x, y+1));
+					if(isBuilding(x, y) && isThin) {
+						cells[size_t(y*w + x)] = 0;
+						isChanged = true;
+					}
+				}
+			}
+		}
+
+		// Tiles of the cells:
+		// TileData copies share their tiles, so each layer is constructed separately:
+		hungerland::procgen::ChunkGenerator::Chunk res;
+		for(size_t i = 0; i < NUM_LAYERS; ++i) {
+			res.emplace_back(size_t(w), size_t(h));
+		}
+		for(int y = 0; y < h; ++y) {
+			for(int x = 0; x < w; ++x) {
+				const auto cell = at(x, y);
+				const bool isH = (cell & ROAD_H) != 0;
+				const bool isV = (cell & ROAD_V) != 0;
+				const int right = x % SIDE == ROAD+1 ? 1 : 0;
+				const int bottom = y % SIDE == ROAD+1 ? 1 : 0;
+				if(isH && isV) {
+					res[ROADS].set(x, y, CROSSING_TILE + right + TILESET_COLUMNS*bottom, 0);
+				} else if(isH) {
+					res[ROADS].set(x, y, ROAD_H_TILE + (x % 4) + TILESET_COLUMNS*bottom, 0);
+				} else if(isV) {
+					res[ROADS].set(x, y, ROAD_V_TILE + right + TILESET_COLUMNS*(y % 4), 0);
+				}
+				if(cell & BUILDING) {
+					// Corner, edge or middle of the roof:
+					const int column = false == isBuilding(x-1, y) ? 0 : (false == isBuilding(x+1, y) ? 2 : 1);
+					const int row = false == isBuilding(x, y-1) ? 0 : (false == isBuilding(x, y+1) ? 2 : 1);
+					const int style = cell >> STYLE_SHIFT;
+					res[COLLISION].set(x, y, BUILDING_TILE + 3*style + column + TILESET_COLUMNS*row, 0);
+				} else {
+					bool isNearRoad = false;
+					for(int ny = y-1; ny <= y+1; ++ny) {
+						for(int nx = x-1; nx <= x+1; ++nx) {
+							isNearRoad = isNearRoad || (at(nx, ny) & (ROAD_H | ROAD_V)) != 0;
+						}
+					}
+					if(isNearRoad) {
+						res[BACKGROUND].set(x, y, SIDEWALK_TILE + (x % 4) + TILESET_COLUMNS*(y % 4), 0);
+					}
+				}
+			}
+		}
+		return res;
+	}
+
+	///
+	/// \brief The Track class. Streams an endless track to a map of fixed size.
+	///
+	/// Map must have tile layers "RoadBG", "RoadTiles" and "CollisionLayer", and its width must be a multiple of
+	/// CHUNK_WIDTH. Chunks are generated by a background thread PREFETCH_CHUNKS ahead of the right edge of the
+	/// map. Chunks are written to the map only in update, so same seed gives the same race regardless of
+	/// thread timing. Agents which drop behind the left edge continue from the start of the map.
+	///
+	class Track {
+	public:
+		static constexpr int AHEAD_CHUNKS = 3;		// Chunks kept in front of the leading car
+		static constexpr int PREFETCH_CHUNKS = 2;	// Chunks generated in advance beyond the right edge of the map
+		static constexpr float GOAL_DISTANCE = 9.0f;	// Distance of the goal ahead of the leading car along the main road
+		static constexpr float RESPAWN_SPACING = 2.5f;	// Distance between pairs of agents continuing from the start
+		static constexpr size_t RESPAWN_ROWS = 4;		// Pairs of agents behind the start until the next agents overlap
+
+		///
+		/// \brief Track Writes the first chunks of the track to the map.
+		/// \param map	= Map of the track.
+		/// \param seed	= Seed of the track.
+		///
+		Track(std::shared_ptr<hungerland::map::Map> map, uint64_t seed)
+			: m_map(map)
+			, m_seed(seed)
+			, m_width(int(map->getMapSize().x))
+			, m_height(int(map->getMapSize().y))
+			, m_layers{map->getLayerHandle("RoadBG"), map->getLayerHandle("RoadTiles"), map->getLayerHandle("CollisionLayer")}
+			, m_wangTiles(SIDE, 2, NUM_STYLES, paintTile)
+			, m_generator([this](int64_t chunk) {
+				return generateChunk(m_wangTiles, m_seed, chunk, m_height);
+			}) {
+			assert(m_width % CHUNK_WIDTH == 0 && m_width >= (AHEAD_CHUNKS + 1)*CHUNK_WIDTH);
+			for(int64_t chunk = 0; chunk < getNumChunks() + PREFETCH_CHUNKS; ++chunk) {
+				m_generator.request(chunk);
+			}
+			for(int64_t chunk = 0; chunk < getNumChunks(); ++chunk) {
+				write(chunk);
+			}
+			buildRoad();
+		}
+
+		///
+		/// \brief getStart
+		/// \return Start position of the first car on the main road near the left edge of the map.
+		///
+		glm::vec2 getStart() const {
+			return glm::vec2(float(ROAD + 5), float(getMainRow(m_seed, m_origin, m_height)));
+		}
+
+		///
+		/// \brief getGoal
+		/// \param position	= Position of the leading car.
+		/// \return Point on the main road GOAL_DISTANCE tiles ahead of the nearest point of the main road to position,
+		/// so that policies steering or searching paths towards the goal follow the main road around its turns.
+		///
+		glm::vec2 getGoal(const glm::vec2& position) const {
+			const auto& points = m_road;
+			// Distance along the main road to the nearest point:
+			float nearestSq = std::numeric_limits<float>::max();
+			float along = 0.0f;
+			float length = 0.0f;
+			for(size_t i = 1; i < points.size(); ++i) {
+				const auto d = points[i] - points[i-1];
+				const float segment = glm::length(d);
+				const float t = segment > 0.0f ? std::clamp(glm::dot(position - points[i-1], d) / (segment*segment), 0.0f, 1.0f) : 0.0f;
+				const auto delta = points[i-1] + t*d - position;
+				if(glm::dot(delta, delta) < nearestSq) {
+					nearestSq = glm::dot(delta, delta);
+					along = length + t*segment;
+				}
+				length += segment;
+			}
+			// Point GOAL_DISTANCE further along the main road:
+			along += GOAL_DISTANCE;
+			for(size_t i = 1; i < points.size(); ++i) {
+				const float segment = glm::length(points[i] - points[i-1]);
+				if(along <= segment) {
+					return points[i-1] + (segment > 0.0f ? along/segment : 0.0f)*(points[i] - points[i-1]);
+				}
+				along -= segment;
+			}
+			return points.back();
+		}
+
+		///
+		/// \brief getOrigin
+		/// \return Index of the chunk at the left edge of the map.
+		///
+		int64_t getOrigin() const {
+			return m_origin;
+		}
+
+		///
+		/// \brief update Scrolls the map by one chunk, if the leading car is less than AHEAD_CHUNKS from the right
+		/// edge. Positions of entities are moved with the map, and goals are moved ahead of the leading car, see getGoal.
+		/// \param game
+		/// \param isForced	= Scroll regardless of the leading car, e.g. to test scrolling with any policy.
+		/// \return true, if the map was scrolled.
+		///
+		template<typename GameState>
+		bool update(GameState& game, bool isForced = false) {
+			auto getLead = [&game]() {
+				glm::vec2 lead(0.0f);
+				for(const auto& agent : game.agents) {
+					if(agent.state.car.position.x > lead.x) {
+						lead = glm::vec2(agent.state.car.position.x, agent.state.car.position.y);
+					}
+				}
+				return lead;
+			};
+			const bool isScrolled = isForced || getLead().x >= float(m_width - AHEAD_CHUNKS*CHUNK_WIDTH);
+			if(isScrolled) {
+				m_map->scrollTiles(CHUNK_WIDTH);
+				++m_origin;
+				write(m_origin + getNumChunks() - 1);
+				m_generator.request(m_origin + getNumChunks() - 1 + PREFETCH_CHUNKS);
+				scroll(game, float(CHUNK_WIDTH));
+				buildRoad();
+			}
+			const auto goal = getGoal(getLead());
+			for(auto& g : game.goals) {
+				g.state = typename GameState::VecType(goal.x, goal.y);
+			}
+			return isScrolled;
+		}
+
+	private:
+		int64_t getNumChunks() const {
+			return m_width / CHUNK_WIDTH;
+		}
+
+		// Main road as a polyline along the middle of the road, see generateChunk. Changes only when the map scrolls.
+		void buildRoad() {
+			auto middle = [this](int64_t chunk) {
+				return float(getMainRow(m_seed, chunk, m_height)) + 0.5f;
+			};
+			m_road.clear();
+			m_road.push_back(glm::vec2(0.0f, middle(m_origin - 1)));
+			for(int64_t i = 0; i < getNumChunks(); ++i) {
+				const float x = float(i*CHUNK_WIDTH + ROAD) + 0.5f;
+				m_road.push_back(glm::vec2(x, middle(m_origin + i - 1)));
+				m_road.push_back(glm::vec2(x, middle(m_origin + i)));
+			}
+			m_road.push_back(glm::vec2(float(m_width - 1), m_road.back().y));
+		}
+
+		void write(int64_t chunk) {
+			const auto tiles = m_generator.get(chunk);
+			const auto x = size_t((chunk - m_origin) * CHUNK_WIDTH);
+			for(size_t i = 0; i < NUM_LAYERS; ++i) {
+				m_map->setTiles(m_layers[i], x, 0, tiles[i]);
+			}
+		}
+
+		template<typename GameState>
+		void scroll(GameState& game, float dx) {
+			typedef typename GameState::VecType VecType;
+			const VecType delta(dx, 0.0f);
+			const auto start = getStart();
+			auto& p = game.projectiles;
+			for(size_t i = 0; i < game.agents.size(); ++i) {
+				auto& state = game.agents[i].state;
+				state.car.position -= delta;
+				state.trailer.position -= delta;
+				if(state.car.position.x < 1.0f || state.trailer.position.x < 1.0f) {
+					// Dropped behind the map. Agents continue in pairs on both lanes, each pair behind the previous one,
+					// so that agents dropped at the same time do not overlap. Cargo on the trailer moves with it:
+					const auto oldTrailer = state.trailer.position;
+					const auto offset = VecType(-RESPAWN_SPACING * float((i / 2) % RESPAWN_ROWS), float(i % 2));
+					state.car.position = VecType(start.x, start.y) + offset;
+					state.trailer.position = state.car.position - VecType(1.0f, 0.0f);
+					state.car.velocity = state.trailer.velocity = VecType(0.0f);
+					state.car.angle = state.trailer.angle = 0.0f;
+					state.car.angularVel = state.trailer.angularVel = 0.0f;
+					state.hitchImpulse = VecType(0.0f);
+					for(const auto slot : p.getAlive()) {
+						const auto cargo = VecType(p.px[slot] - dx, p.py[slot]) - oldTrailer;
+						if(size_t(p.owner[slot]) == i && std::abs(cargo.x) < 1.0f && std::abs(cargo.y) < 1.0f) {
+							p.px[slot] = state.trailer.position.x + p.ox[slot] + dx;
+							p.py[slot] = state.trailer.position.y + p.oy[slot];
+							p.vx[slot] = p.vy[slot] = 0.0f;
+						}
+					}
+				}
+			}
+			auto isBehind = [](const auto& item) {
+				return item.state.position.x < 0.0f;
+			};
+			for(auto& item : game.items) {
+				item.state.position -= delta;
+			}
+			for(auto& item : game.sleepingItems) {
+				item.state.position -= delta;
+			}
+			game.items.erase(std::remove_if(game.items.begin(), game.items.end(), isBehind), game.items.end());
+			game.sleepingItems.erase(std::remove_if(game.sleepingItems.begin(), game.sleepingItems.end(), isBehind), game.sleepingItems.end());
+			game.sleepingChanged = true;
+			std::vector<uint32_t> behind;
+			for(const auto slot : p.getAlive()) {
+				p.px[slot] -= dx;
+				if(p.px[slot] < 0.0f) {
+					behind.push_back(slot);
+				}
+			}
+			for(const auto slot : behind) {
+				p.despawn(slot);
+			}
+		}
+
+		std::shared_ptr<hungerland::map::Map>	m_map;
+		uint64_t								m_seed;
+		int										m_width;
+		int										m_height;
+		hungerland::map::Map::LayerHandle		m_layers[NUM_LAYERS];	// Map layer of each Layer
+		int64_t									m_origin = 0;			// Chunk at the left edge of the map
+		std::vector<glm::vec2>					m_road;					// Main road of the map, see buildRoad
+		hungerland::procgen::WangTiles			m_wangTiles;
+		hungerland::procgen::ChunkGenerator		m_generator;			// Last member: thread is stopped first
+	};
+} // End - namespace car_endless
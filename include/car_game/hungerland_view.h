@@ -52,16 +52,52 @@ namespace render {
 		}
 	};
 
+	///
+	/// \brief render::projectiles Renders projectile pool in batches of same visual.
+	/// \param f		= f(const std::vector<glm::mat4>&, const Texture&) draws batch of sprites.
+	/// \param state
+	/// \param batches	= Transforms of each visual, kept over frames to avoid allocations.
+	///
+	template<typename F, typename GameState>
+	auto projectiles(F f, const GameState& state, std::vector<std::vector<glm::mat4>>& batches) {
+		batches.resize(state.textures.size());
+		for(auto& batch : batches) {
+			batch.clear();
+		}
+		const auto& p = state.projectiles;
+		const auto scale = glm::scale(glm::mat4(1), glm::vec3(p.sx, p.sy, 0));
+		for(const auto slot : p.getAlive()) {
+			const auto visualId = p.visualId[slot];
+			if(visualId < 0 || size_t(visualId) >= batches.size()) continue; // No visual, skip
+			const auto translate = glm::translate(glm::mat4(1), glm::vec3(p.px[slot], p.py[slot], 0));
+			const auto rotate = glm::rotate(glm::mat4(1), p.angle[slot], glm::vec3(0, 0, 1));
+			batches[visualId].push_back(translate * rotate * scale);
+		}
+		for(size_t visualId = 0; visualId < batches.size(); ++visualId) {
+			if(false == batches[visualId].empty()) {
+				f(batches[visualId], *state.textures[visualId]);
+			}
+		}
+	}
+
 } // End - namespace render
 
+	///
+	/// \brief The RenderBuffers class. Buffers of renderState, kept over frames to avoid allocations each frame.
+	///
+	struct RenderBuffers {
+		std::vector<std::vector<glm::mat4>>	batches;	// Projectile transforms of each visual, see render::projectiles
+		std::vector<glm::mat4>				transforms;	// Batch in screen coordinates
+	};
 
 	///
 	/// \brief renderState
 	/// \param screen
 	/// \param state
+	/// \param buffers
 	///
 	template<typename Screen, typename GameState>
-	void renderState(Screen& screen, const GameState& state) {
+	void renderState(Screen& screen, const GameState& state, RenderBuffers& buffers) {
 		auto matProj = screen.setScreen(0.0f, 1280.0f, 768.0f, 0.0f);
 		screen.clear(0.5f, 0.0f, 0.5f, 1.0f);
 		auto cameraPosition = glm::vec3(0);
@@ -75,6 +111,16 @@ namespace render {
 			auto mat = glm::translate(glm::mat4(1), camOffset - cameraPosition + glm::vec3(0.5f, 0.5f, 0.0f));
 			screen.drawSprite(scaleMat*mat*M, /*getTexture(texture)*/texture);
 		};
+		const auto batchRenderer = [&](const std::vector<glm::mat4>& Ms, const hungerland::texture::Texture& texture) {
+			auto& transforms = buffers.transforms;
+			auto scaleMat = glm::scale(glm::mat4(1), { 64.0f, 64.0f, 1.0f });
+			auto mat = glm::translate(glm::mat4(1), camOffset - cameraPosition + glm::vec3(0.5f, 0.5f, 0.0f));
+			transforms.clear();
+			for(const auto& M : Ms) {
+				transforms.push_back(scaleMat*mat*M);
+			}
+			screen.drawSprites(transforms, texture);
+		};
 
 		auto renderAgent = [&state,&renderer](auto agentId, const auto& agent) {
 			render::agent(renderer, state, agent);
@@ -102,7 +148,8 @@ namespace render {
 		// Render agent cars:
 		utils::forEach(state.agents, renderAgent);
 		utils::forEach(state.items, renderEntity);
-		utils::forEach(state.projectiles, renderEntity);
+		utils::forEach(state.sleepingItems, renderEntity);
+		render::projectiles(batchRenderer, state, buffers.batches);
 		auto scaleMat = glm::scale(glm::mat4(1), { 4.0f, 4.0f, 1.0f });
 		//auto mat = glm::translate(glm::mat4(1), camOffset - cameraPosition + glm::vec3(0.5f, 0.5f, 0.0f));
 		auto mat = glm::translate(glm::mat4(1), cameraPosition - glm::vec3(8.0f, 4.0f, 0.0f));
@@ -162,6 +209,7 @@ namespace render {
 		int n=0;
 		float totalTime=0;
 		int soundPlaying = -1;
+		RenderBuffers renderBuffers;
 		int res = window.run([&](auto& window, float dt) {
 			//printf("\nFrame=%d, totalTime=%2.2f\n", n++, totalTime);
 			totalTime += dt;
@@ -176,7 +224,7 @@ namespace render {
 			}
 			return true;
 		}, [&](auto& screen) {
-			renderState(screen, gameState);
+			renderState(screen, gameState, renderBuffers);
 		});
 
 #if defined(_WIN32) ||defined(WIN32)
@@ -2,6 +2,13 @@
 ///
 /// MODEL: Sovelluksen datan tietorakenteiden määrittelyt:
 #include <meta.h> // Meta classes for model
+#include <spatial_hash.h> // Broadphase grid
+#include <pool.h>		// Projectile pool slots
+#include <substep.h>	// Sub-step plans
+#include <rng.h>		// Random numbers of the world
+#include <occupancy.h>	// Occupancy grid
+#include <hungerland/integrator.h> // Batch integrated bodies
+#include <algorithm>	// std::max
 #include <functional>	// std::function
 #include <memory>		// std::shared_ptr
 
@@ -40,6 +47,7 @@ namespace car_model {
 	struct AgentState {
 		CarState<VecType> car;
 		TrailerState<VisualType,VecType> trailer;
+		VecType hitchImpulse = VecType(0); // Accumulated hitch joint impulse for warm starting
 		size_t targetId = 0;
 	};
 
@@ -52,10 +60,11 @@ namespace car_model {
 		float angle = 0.0f;
 		float sx = 0.5f;
 		float sy = 0.5f;
+		VecType	velocity = VecType(0);
 	};
 
 	///
-	/// \brief The ProjectileState class
+	/// \brief The ProjectileState class. Initial state of spawned projectile.
 	///
 	template<typename VecType>
 	struct ProjectileState {
@@ -66,7 +75,129 @@ namespace car_model {
 		float angle = 0.0f;
 		float sx = 0.25f;
 		float sy = 0.25f;
-		int state;
+		int state = 0;
+	};
+
+	///
+	/// \brief The ProjectilePool class
+	///
+	/// Fixed capacity projectile storage as structure of arrays. Slot index is the projectile id.
+	/// Spawning and despawning reuse slots from the free list, so those never allocate.
+	///
+	template<typename VisualType>
+	struct ProjectilePool {
+		ProjectilePool()
+			: ProjectilePool(0) {
+		}
+
+		explicit ProjectilePool(size_t capacity)
+			: slots(capacity)
+			, owner(capacity, 0)
+			, visualId(capacity, -1)
+			, state(capacity, 0)
+			, px(capacity, 0.0f), py(capacity, 0.0f)
+			, vx(capacity, 0.0f), vy(capacity, 0.0f)
+			, ox(capacity, 0.0f), oy(capacity, 0.0f)
+			, angle(capacity, 0.0f)
+			, timer(capacity, 0.0f) {
+		}
+
+		///
+		/// \brief spawn
+		/// \return Slot of new projectile or pool::Slots::INVALID, if pool is full.
+		///
+		uint32_t spawn(int ownerId, VisualType visual, int initialState) {
+			const auto slot = slots.spawn();
+			if(slot == pool::Slots::INVALID) {
+				return slot;
+			}
+			owner[slot] = int16_t(ownerId);
+			visualId[slot] = visual;
+			state[slot] = uint8_t(initialState);
+			px[slot] = py[slot] = 0.0f;
+			vx[slot] = vy[slot] = 0.0f;
+			ox[slot] = oy[slot] = 0.0f;
+			angle[slot] = 0.0f;
+			timer[slot] = 0.0f;
+			return slot;
+		}
+
+		void despawn(uint32_t slot) {
+			slots.despawn(slot);
+		}
+
+		const std::vector<uint32_t>& getAlive() const {
+			return slots.getAlive();
+		}
+
+		size_t size() const {
+			return slots.size();
+		}
+
+		pool::Slots				slots;
+		std::vector<int16_t>	owner;
+		std::vector<VisualType>	visualId;
+		std::vector<uint8_t>	state;
+		std::vector<float>		px, py;		// Position
+		std::vector<float>		vx, vy;		// Velocity
+		std::vector<float>		ox, oy;		// Offset on owner trailer
+		std::vector<float>		angle;
+		std::vector<float>		timer;		// Time in current state
+		float					sx = 0.25f;
+		float					sy = 0.25f;
+	};
+
+	///
+	/// \brief The Timings class. Time spent in update phases in seconds.
+	///
+	struct Timings {
+		double substeps = 0;	// car_env::scheduleSubsteps
+		double sensors = 0;		// car_env::updateSensors
+		double policy = 0;		// Policy functions of agents
+		double cars = 0;		// Car and trailer steps of agents
+		double occupancy = 0;	// car_env::updateOccupancy
+		double items = 0;		// Stepping and integrating items
+		double projectiles = 0;	// Stepping and integrating projectiles
+		double tiles = 0;		// car_env::resolveTileCollisions
+		double sleeping = 0;	// Putting resting items to sleep
+		double contacts = 0;	// Waking, broadphase, contacts and targets
+	};
+
+	///
+	/// \brief The Sensors class. Ray sensor distances of each agent, rebuilt each update.
+	///
+	struct Sensors {
+		std::vector<float>	angles;		// Ray angles relative to car heading.
+		std::vector<float>	walls;		// Distance to collision tiles, angles.size() per agent.
+		std::vector<float>	roadEdges;	// Distance to end of road, angles.size() per agent.
+	};
+
+	///
+	/// \brief The Scratch class. Buffers of update phases, kept over updates to avoid allocations each frame.
+	/// Contents are valid only during the phase which fills them.
+	///
+	template<typename MapType>
+	struct Scratch {
+		hungerland::integrator::Bodies				bodies;		// Batch of car_env::integrateEntities and integrateProjectiles
+		std::vector<size_t>							ids;		// Entity or projectile slot of each body
+		std::vector<glm::vec4>						trailers;	// Trailer frames of car_env::stepProjectiles
+		std::vector<typename MapType::BoxQuery>		queries;	// Boxes of car_env::resolveTileCollisions
+		std::vector<typename MapType::Contact>		contacts;
+		std::vector<uint32_t>						flying;		// Projectile slot of each query after items
+		std::vector<substep::Request>				requests;	// Bodies of car_env::scheduleSubsteps
+		std::vector<glm::vec2>						origins;	// Rays of car_env::updateSensors
+		std::vector<float>							headings;
+		std::vector<typename MapType::RayHit>		hits;
+		std::vector<uint32_t>						wakeIds;	// Sleeping items of car_env::wakeRadius and wakeTouched
+	};
+
+	///
+	/// \brief The Layers class. Tile layers of the map used by the simulation, see car_env::resolveLayers.
+	///
+	template<typename LayerHandle>
+	struct Layers {
+		LayerHandle	road;		// "RoadTiles": ground surface, AI drives on it.
+		LayerHandle	collision;	// "CollisionLayer": walls.
 	};
 
 	template<typename Scalar>
@@ -89,6 +220,7 @@ namespace car_model {
 		typedef int8_t		VisualType;
 		typedef VecT		VecType;
 		typedef std::shared_ptr<Texture>	TexturePtr;
+		typedef typename MapType::LayerHandle	LayerHandle;
 
 		/// Policy and event func types
 		typedef std::function<Action(AgentId, const GameState&)>	PolicyFunc;
@@ -116,8 +248,8 @@ namespace car_model {
 		typedef meta::Entity<MetaClass, ItemState,PolicyFunc,EventFunc>		EntityItem;
 		typedef meta::Prefab<MetaClass, ItemState>							PrefabItem;
 		// Projectile
-		typedef meta::Entity<MetaClass,ProjectileState,PolicyFunc,EventFunc>EntityProjectile;
 		typedef meta::Prefab<MetaClass,ProjectileState>						PrefabProjectile;
+		typedef car_model::ProjectilePool<VisualType>						ProjectilePool;
 
 		/// Constant attributes in game state:
 		// Entiteettiluokat
@@ -136,10 +268,33 @@ namespace car_model {
 		std::vector<EntityItem>			items;
 
 		/// "Dynamic" entities, initially empty:
-		std::vector<EntityProjectile>	projectiles;
+		ProjectilePool					projectiles;
 		std::vector<Goal>				goals;
+
+		/// Members below have default initializers, so game is aggregate initialized only up to goals:
 		float totalTime = 0.0f;
 		bool isRunning = false;
+
+		/// Determinism: all randomness of the simulation comes from the seed, see car_env::seed.
+		uint64_t						seed = 0;
+		uint64_t						numSteps = 0;	// Number of updates done.
+		rng::Random						random{};
+
+		/// Tile layers of the map, resolved once after the map is loaded:
+		car_model::Layers<LayerHandle>	layers{};
+
+		/// Sleeping entities, which are not updated until woken:
+		std::vector<EntityItem>			sleepingItems{};
+
+		/// Runtime data, rebuilt each update:
+		spatial_hash::Grid				broadphase{};
+		spatial_hash::Grid				sleepingBroadphase{}; // Rebuilt only when sleeping entities change.
+		bool							sleepingChanged = true;
+		occupancy::Grid					occupancy{};	// Updated incrementally: car of agent i has id 2*i, trailer 2*i+1.
+		std::vector<substep::Plan>		substeps{};	// Integration plan of each car and trailer
+		Sensors							sensors{};
+		Timings							timings{};
+		Scratch<MapType>				scratch{};
 	};
 
 
@@ -169,6 +324,24 @@ namespace car_model {
 		return res;
 	}
 
+	///
+	/// \brief model::genProjectiles
+	/// \param capacity	= Maximum number of projectiles alive at the same time.
+	/// \param prefabs	= Projectiles to spawn.
+	///
+	template<typename Pool, typename Prefab>
+	auto genProjectiles(size_t capacity, const std::vector<Prefab>& prefabs) {
+		Pool res(std::max(capacity, prefabs.size()));
+		for(const auto& prefab : prefabs) {
+			const auto slot = res.spawn(prefab.state.owner, prefab.type.visualId, prefab.state.state);
+			res.px[slot] = prefab.state.position.x;
+			res.py[slot] = prefab.state.position.y;
+			res.ox[slot] = prefab.state.offset.x;
+			res.oy[slot] = prefab.state.offset.y;
+		}
+		return res;
+	}
+
 	///
 	/// \brief model::genTileMap
 	/// \param sx		= Mapin x koko.
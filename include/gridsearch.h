@@ -40,6 +40,7 @@ struct GameState {
 	struct AgentState {
 		Position			position;
 		std::vector<size_t> actions;
+		float				pathCost = 0; // Sum of step costs of cells left on the way here, see searchWaypoints.
 		// TODO: add open list, closed list and path positions here.
 	};
 
@@ -67,15 +68,16 @@ struct GameState {
 	QCostFunc		getQCost;
 };
 
-////
+///
 /// \brief searchWaypoints
 /// \param start
 /// \param end
 /// \param isLegalState
+/// \param getStepCost	= getStepCost(const GameState::Position&) -> float. Cost of entering a cell, at least 1.
 /// \param MAX_ITERS
 ///
-template<typename VecType, typename IsLegalStateFunc>
-auto searchWaypoints(const VecType& start, const VecType& end, IsLegalStateFunc isLegalState, int MAX_ITERS) {
+template<typename VecType, typename IsLegalStateFunc, typename StepCostFunc>
+auto searchWaypoints(const VecType& start, const VecType& end, IsLegalStateFunc isLegalState, StepCostFunc getStepCost, int MAX_ITERS) {
 	typedef SearchNode<gridsearch::GameState> NodeType;
 	auto createSearch = [](const VecType& start, const VecType& goal) {
 		return gridsearch::GameState {
@@ -90,14 +92,9 @@ auto searchWaypoints(const VecType& start, const VecType& end, IsLegalStateFunc
 		return gameState.getHCost(agentId, gameState);
 	};
 
-	// G(n) -> float
-	auto getGCost = [](std::shared_ptr<NodeType> node, auto agentId, const auto& gameState) {
-		float gCost = 0;
-		while (node != 0) {
-			gCost += 1.0f;
-			node = node->prevNode;
-		}
-		return gCost;
+	// G(n) -> float. Accumulated by predict, so the path is not walked again for each node:
+	auto getGCost = [](std::shared_ptr<NodeType>, auto, const auto& gameState) {
+		return gameState.agents[0].state.pathCost;
 	};
 
 	// F(n) = G + H  -> float
@@ -127,9 +124,11 @@ auto searchWaypoints(const VecType& start, const VecType& end, IsLegalStateFunc
 		},
 	};
 	searchGame.numActions = searchGame.actions.size();
-	searchGame.predict = [](auto& game, auto agentId, auto actionId) {
+	searchGame.predict = [&getStepCost](auto& game, auto agentId, auto actionId) {
 		// Check errorneus actionId
 		if(actionId >= game.actions.size()) return false;
+		// Add cost of the cell left to G of the new state:
+		game.agents[0].state.pathCost += getStepCost(game.agents[0].state.position);
 		// Apply agent action by actionId
 		game.actions[actionId](game, actionId);
 		// Return true, if agent made legal action, which leads to legal state
@@ -169,6 +168,18 @@ auto searchWaypoints(const VecType& start, const VecType& end, IsLegalStateFunc
 	return waypoints;
 }
 
+///
+/// \brief searchWaypoints Searches with cost 1 for each step.
+/// \param start
+/// \param end
+/// \param isLegalState
+/// \param MAX_ITERS
+///
+template<typename VecType, typename IsLegalStateFunc>
+auto searchWaypoints(const VecType& start, const VecType& end, IsLegalStateFunc isLegalState, int MAX_ITERS) {
+	return searchWaypoints(start, end, isLegalState, [](const GameState::Position&) { return 1.0f; }, MAX_ITERS);
+}
+
 
 } // End - namespace gridsearch
 
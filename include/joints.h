@@ -0,0 +1,180 @@
+#pragma once
+#include <assert.h>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <hungerland/math.h> // Deterministic sin and cos
+
+///
+/// JOINTS: 2D rigid body joints solved with sequential impulses.
+/// - joints::Body
+/// - joints::RevoluteJoint
+/// - joints::solve(bodies, joints, iterations, dt) -> void
+/// - joints::solvePositions(bodies, joints, iterations) -> float
+///
+namespace joints {
+	///
+	/// \brief The Body class. Solver copy of rigid body state.
+	///
+	struct Body {
+		glm::vec2	position = glm::vec2(0);
+		float		angle = 0.0f;
+		glm::vec2	velocity = glm::vec2(0);
+		float		angularVel = 0.0f;
+		float		invMass = 1.0f;
+		float		invInertia = 1.0f;
+	};
+
+	///
+	/// \brief The RevoluteJoint class. Pins anchor point of body A to anchor point of body B.
+	/// Accumulated impulse is kept between steps for warm starting.
+	///
+	struct RevoluteJoint {
+		size_t		bodyA = 0;
+		size_t		bodyB = 0;
+		glm::vec2	localAnchorA = glm::vec2(0);
+		glm::vec2	localAnchorB = glm::vec2(0);
+		glm::vec2	impulse = glm::vec2(0);
+		// Solver data of current step:
+		glm::vec2	rA = glm::vec2(0);
+		glm::vec2	rB = glm::vec2(0);
+		glm::mat2	invK = glm::mat2(1);
+		glm::vec2	bias = glm::vec2(0);
+	};
+
+	///
+	/// \brief createBody
+	/// \param body		= Body with position, angle, velocity, angularVel, sx and sy.
+	/// \param mass
+	/// \return Solver body of box shaped body.
+	///
+	template<typename BodyType>
+	Body createBody(const BodyType& body, float mass) {
+		Body b;
+		b.position = glm::vec2(body.position.x, body.position.y);
+		b.angle = body.angle;
+		b.velocity = glm::vec2(body.velocity.x, body.velocity.y);
+		b.angularVel = body.angularVel;
+		b.invMass = mass > 0.0f ? 1.0f/mass : 0.0f;
+		const float inertia = mass * (body.sx*body.sx + body.sy*body.sy) / 12.0f;
+		b.invInertia = inertia > 0.0f ? 1.0f/inertia : 0.0f;
+		return b;
+	}
+
+	///
+	/// \brief applyVelocity Copies solved velocities back to the body.
+	///
+	template<typename BodyType>
+	void applyVelocity(BodyType& body, const Body& b) {
+		body.velocity.x = b.velocity.x;
+		body.velocity.y = b.velocity.y;
+		body.angularVel = b.angularVel;
+	}
+
+	static inline glm::vec2 rotate(float angle, const glm::vec2& v) {
+		float s, c;
+		hungerland::math::sincos(angle, s, c);
+		return glm::vec2(c*v.x - s*v.y, s*v.x + c*v.y);
+	}
+
+	static inline float cross(const glm::vec2& a, const glm::vec2& b) {
+		return a.x*b.y - a.y*b.x;
+	}
+
+	static inline glm::vec2 cross(float w, const glm::vec2& r) {
+		return glm::vec2(-w*r.y, w*r.x);
+	}
+
+	///
+	/// \brief solve Solves joint velocity constraints with sequential impulses.
+	/// Position drift is corrected with Baumgarte stabilization.
+	/// \param bodies		= Container of Body, velocities are updated.
+	/// \param joints		= Container of RevoluteJoint, accumulated impulses are updated.
+	/// \param iterations	= Number of velocity iterations.
+	/// \param dt			= Time step.
+	///
+	template<typename Bodies, typename Joints>
+	void solve(Bodies& bodies, Joints& joints, size_t iterations, float dt) {
+		const float BAUMGARTE = 0.2f;
+		if(dt <= 0.0f) {
+			return;
+		}
+
+		auto applyImpulse = [&bodies](const RevoluteJoint& j, const glm::vec2& P) {
+			auto& a = bodies[j.bodyA];
+			auto& b = bodies[j.bodyB];
+			a.velocity -= a.invMass * P;
+			a.angularVel -= a.invInertia * cross(j.rA, P);
+			b.velocity += b.invMass * P;
+			b.angularVel += b.invInertia * cross(j.rB, P);
+		};
+
+		// Prepare and warm start:
+		for(auto& j : joints) {
+			assert(j.bodyA < bodies.size() && j.bodyB < bodies.size());
+			const auto& a = bodies[j.bodyA];
+			const auto& b = bodies[j.bodyB];
+			j.rA = rotate(a.angle, j.localAnchorA);
+			j.rB = rotate(b.angle, j.localAnchorB);
+			const float mA = a.invMass, mB = b.invMass;
+			const float iA = a.invInertia, iB = b.invInertia;
+			glm::mat2 K;
+			K[0][0] = mA + mB + iA*j.rA.y*j.rA.y + iB*j.rB.y*j.rB.y;
+			K[0][1] = -iA*j.rA.x*j.rA.y - iB*j.rB.x*j.rB.y;
+			K[1][0] = K[0][1];
+			K[1][1] = mA + mB + iA*j.rA.x*j.rA.x + iB*j.rB.x*j.rB.x;
+			j.invK = glm::inverse(K);
+			const auto C = (b.position + j.rB) - (a.position + j.rA);
+			j.bias = (BAUMGARTE/dt) * C;
+			applyImpulse(j, j.impulse);
+		}
+
+		// Velocity iterations:
+		for(size_t it=0; it<iterations; ++it) {
+			for(auto& j : joints) {
+				const auto& a = bodies[j.bodyA];
+				const auto& b = bodies[j.bodyB];
+				const auto Cdot = b.velocity + cross(b.angularVel, j.rB) - a.velocity - cross(a.angularVel, j.rA);
+				const auto P = -(j.invK * (Cdot + j.bias));
+				j.impulse += P;
+				applyImpulse(j, P);
+			}
+		}
+	}
+
+	///
+	/// \brief solvePositions Removes remaining position error of joints after integration (non-linear Gauss-Seidel).
+	/// \param bodies		= Container of Body, positions and angles are updated.
+	/// \param joints		= Container of RevoluteJoint.
+	/// \param iterations	= Number of position iterations.
+	/// \return Largest position error before last iteration.
+	///
+	template<typename Bodies, typename Joints>
+	float solvePositions(Bodies& bodies, Joints& joints, size_t iterations) {
+		float maxError = 0.0f;
+		for(size_t it=0; it<iterations; ++it) {
+			maxError = 0.0f;
+			for(const auto& j : joints) {
+				auto& a = bodies[j.bodyA];
+				auto& b = bodies[j.bodyB];
+				const auto rA = rotate(a.angle, j.localAnchorA);
+				const auto rB = rotate(b.angle, j.localAnchorB);
+				const auto C = (b.position + rB) - (a.position + rA);
+				maxError = std::max(maxError, glm::length(C));
+				const float mA = a.invMass, mB = b.invMass;
+				const float iA = a.invInertia, iB = b.invInertia;
+				glm::mat2 K;
+				K[0][0] = mA + mB + iA*rA.y*rA.y + iB*rB.y*rB.y;
+				K[0][1] = -iA*rA.x*rA.y - iB*rB.x*rB.y;
+				K[1][0] = K[0][1];
+				K[1][1] = mA + mB + iA*rA.x*rA.x + iB*rB.x*rB.x;
+				const auto P = -(glm::inverse(K) * C);
+				a.position -= mA * P;
+				a.angle -= iA * cross(rA, P);
+				b.position += mB * P;
+				b.angle += iB * cross(rB, P);
+			}
+		}
+		return maxError;
+	}
+} // End - namespace joints
@@ -33,6 +33,7 @@ namespace meta {
 		EventFunc		event		= 0;
 		bool			isAlive		= true;
 		float			coolDownTimer = 0.0f; // When cooldown timer > 0, object policy is not called.
+		float			restTimer = 0.0f; // Time the entity has been at rest. Long resting entities are put to sleep.
 	};
 
 	template<typename ClassType, typename State>
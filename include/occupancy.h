@@ -0,0 +1,172 @@
+#pragma once
+#include <assert.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace occupancy {
+
+///
+/// \brief The Grid class
+///
+/// Occupancy grid aligned with the tile map: each tile cell knows ids of dynamic bodies whose
+/// center is on the tile. Tile at x,y covers area [x-0.5, x+0.5]. Unlike spatial_hash::Grid, this
+/// grid is not rebuilt each tick. Bodies are moved between cells only when they cross a cell
+/// boundary, so a tick where nobody changes tile costs one compare per body. Each cell has an
+/// intrusive doubly linked list of ids, so moving a body is O(1) and nothing is allocated after
+/// the first update of each id.
+///
+class Grid {
+public:
+	static constexpr uint32_t NONE = 0xffffffffu;
+
+	Grid()
+		: Grid(0, 0) {
+	}
+
+	Grid(size_t width, size_t height)
+		: m_width(width)
+		, m_height(height)
+		, m_heads(width*height, NONE) {
+	}
+
+	///
+	/// \brief update Moves body to the cell of given position. Bodies outside of the grid are not in any cell.
+	/// \param id	= Body id. Ids should be small and dense, storage grows to the largest id.
+	/// \param x	= Map x coordinate of body center.
+	/// \param y	= Map y coordinate of body center.
+	/// \return true, if body changed cell.
+	///
+	bool update(uint32_t id, float x, float y) {
+		if(id >= m_cellOf.size()) {
+			m_cellOf.resize(id+1, NONE);
+			m_next.resize(id+1, NONE);
+			m_prev.resize(id+1, NONE);
+		}
+		const auto cell = getCellIndex(getCell(x), getCell(y));
+		if(cell == m_cellOf[id]) {
+			return false;
+		}
+		unlink(id);
+		link(id, cell);
+		return true;
+	}
+
+	///
+	/// \brief remove Removes body from the grid.
+	///
+	void remove(uint32_t id) {
+		if(id < m_cellOf.size()) {
+			unlink(id);
+		}
+	}
+
+	///
+	/// \brief forEach Calls f(uint32_t id) for each body in cell cx,cy.
+	///
+	template<typename Func>
+	void forEach(int cx, int cy, Func f) const {
+		const auto cell = getCellIndex(cx, cy);
+		if(cell == NONE) {
+			return;
+		}
+		for(auto id = m_heads[cell]; id != NONE; id = m_next[id]) {
+			f(id);
+		}
+	}
+
+	///
+	/// \brief forNeighbours Calls f(uint32_t id) for each body in cells at most reach cells away from the cell of x,y.
+	/// Bodies of radius r1 and r2 can touch only if reach >= ceil(r1+r2).
+	///
+	template<typename Func>
+	void forNeighbours(float x, float y, int reach, Func f) const {
+		const int cx = getCell(x);
+		const int cy = getCell(y);
+		for(int ny=cy-reach; ny<=cy+reach; ++ny) {
+			for(int nx=cx-reach; nx<=cx+reach; ++nx) {
+				forEach(nx, ny, f);
+			}
+		}
+	}
+
+	///
+	/// \brief isOccupied
+	/// \param ignore	= f(uint32_t id) -> bool. Ignored bodies (e.g. own car) do not occupy cells.
+	/// \return true, if any body which is not ignored is in cell cx,cy.
+	///
+	template<typename IgnoreFunc>
+	bool isOccupied(int cx, int cy, IgnoreFunc ignore) const {
+		const auto cell = getCellIndex(cx, cy);
+		if(cell == NONE) {
+			return false;
+		}
+		for(auto id = m_heads[cell]; id != NONE; id = m_next[id]) {
+			if(false == ignore(id)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	size_t getWidth() const {
+		return m_width;
+	}
+
+	size_t getHeight() const {
+		return m_height;
+	}
+
+private:
+	static int getCell(float v) {
+		return int(std::floor(v + 0.5f));
+	}
+
+	uint32_t getCellIndex(int cx, int cy) const {
+		if(cx < 0 || cy < 0 || size_t(cx) >= m_width || size_t(cy) >= m_height) {
+			return NONE;
+		}
+		return uint32_t(size_t(cy)*m_width + size_t(cx));
+	}
+
+	void link(uint32_t id, uint32_t cell) {
+		m_cellOf[id] = cell;
+		if(cell == NONE) {
+			return;
+		}
+		m_prev[id] = NONE;
+		m_next[id] = m_heads[cell];
+		if(m_heads[cell] != NONE) {
+			m_prev[m_heads[cell]] = id;
+		}
+		m_heads[cell] = id;
+	}
+
+	void unlink(uint32_t id) {
+		const auto cell = m_cellOf[id];
+		if(cell == NONE) {
+			return;
+		}
+		if(m_prev[id] != NONE) {
+			m_next[m_prev[id]] = m_next[id];
+		} else {
+			assert(m_heads[cell] == id);
+			m_heads[cell] = m_next[id];
+		}
+		if(m_next[id] != NONE) {
+			m_prev[m_next[id]] = m_prev[id];
+		}
+		m_cellOf[id] = NONE;
+		m_next[id] = NONE;
+		m_prev[id] = NONE;
+	}
+
+	size_t					m_width;
+	size_t					m_height;
+	std::vector<uint32_t>	m_heads;	// First body id of each cell.
+	std::vector<uint32_t>	m_cellOf;	// Cell of each body id or NONE.
+	std::vector<uint32_t>	m_next;		// Next body id in the same cell.
+	std::vector<uint32_t>	m_prev;		// Previous body id in the same cell.
+};
+
+} // End - namespace occupancy
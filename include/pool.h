@@ -0,0 +1,84 @@
+#pragma once
+#include <assert.h>
+#include <cstdint>
+#include <vector>
+
+namespace pool {
+
+///
+/// \brief The Slots class
+///
+/// Fixed number of slots allocated through a free list. Alive slots are kept in a dense list,
+/// so iterating alive slots costs only by the number of alive slots. Nothing is allocated after
+/// construction: spawn pops a slot from the free list and despawn swaps it out of the alive list.
+///
+class Slots {
+public:
+	static constexpr uint32_t INVALID = 0xffffffffu;
+
+	Slots()
+		: Slots(0) {
+	}
+
+	explicit Slots(size_t capacity)
+		: m_alivePos(capacity, INVALID) {
+		m_alive.reserve(capacity);
+		m_free.reserve(capacity);
+		// Lowest slots are spawned first:
+		for(size_t i=capacity; i-- > 0; ) {
+			m_free.push_back(uint32_t(i));
+		}
+	}
+
+	///
+	/// \brief spawn
+	/// \return Index of spawned slot or INVALID, if all slots are in use.
+	///
+	uint32_t spawn() {
+		if(m_free.empty()) {
+			return INVALID;
+		}
+		const auto slot = m_free.back();
+		m_free.pop_back();
+		m_alivePos[slot] = uint32_t(m_alive.size());
+		m_alive.push_back(slot);
+		return slot;
+	}
+
+	///
+	/// \brief despawn Returns slot to the free list. Last alive slot is moved to its place in the alive list.
+	///
+	void despawn(uint32_t slot) {
+		assert(isAlive(slot));
+		const auto pos = m_alivePos[slot];
+		const auto last = m_alive.back();
+		m_alive[pos] = last;
+		m_alivePos[last] = pos;
+		m_alive.pop_back();
+		m_alivePos[slot] = INVALID;
+		m_free.push_back(slot);
+	}
+
+	bool isAlive(uint32_t slot) const {
+		return slot < m_alivePos.size() && m_alivePos[slot] != INVALID;
+	}
+
+	const std::vector<uint32_t>& getAlive() const {
+		return m_alive;
+	}
+
+	size_t size() const {
+		return m_alive.size();
+	}
+
+	size_t capacity() const {
+		return m_alivePos.size();
+	}
+
+private:
+	std::vector<uint32_t>	m_alive;	// Dense list of alive slots.
+	std::vector<uint32_t>	m_alivePos;	// Position of each slot in alive list or INVALID.
+	std::vector<uint32_t>	m_free;		// Stack of free slots.
+};
+
+} // End - namespace pool
@@ -0,0 +1,94 @@
+#pragma once
+#include <assert.h>
+#include <cstdint>
+
+///
+/// RNG: Seedable deterministic random numbers.
+/// - rng::mix(x) -> uint64_t
+/// - rng::combine(seed, a, b) -> uint64_t
+/// - rng::Random
+///
+namespace rng {
+	///
+	/// \brief mix SplitMix64 finalizer. Maps each input to a well scrambled output.
+	///
+	inline uint64_t mix(uint64_t x) {
+		x += 0x9e3779b97f4a7c15ull;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+		return x ^ (x >> 31);
+	}
+
+	///
+	/// \brief combine Derives a seed from a seed and counters, for example world seed, step and agent id.
+	/// Code which can't modify random state (policies of const game state) can seed a Random from it.
+	///
+	inline uint64_t combine(uint64_t seed, uint64_t a, uint64_t b = 0) {
+		return mix(mix(mix(seed) ^ a) ^ b);
+	}
+
+	///
+	/// \brief The Random class. PCG32 generator: 64 bit state, 32 bit output.
+	///
+	/// Same seed gives the same sequence on all platforms, unlike rand(). Floats are made from
+	/// integer bits only, so they are bit identical too.
+	///
+	class Random {
+	public:
+		Random()
+			: Random(0) {
+		}
+
+		explicit Random(uint64_t seed)
+			: m_state(0) {
+			next();
+			m_state += mix(seed);
+			next();
+		}
+
+		///
+		/// \brief next
+		/// \return Next 32 random bits.
+		///
+		uint32_t next() {
+			const uint64_t old = m_state;
+			m_state = old * 6364136223846793005ull + INCREMENT;
+			const uint32_t xorShifted = uint32_t(((old >> 18u) ^ old) >> 27u);
+			const uint32_t rot = uint32_t(old >> 59u);
+			return (xorShifted >> rot) | (xorShifted << ((32u - rot) & 31u));
+		}
+
+		///
+		/// \brief below
+		/// \return Random integer in range [0, n).
+		///
+		uint32_t below(uint32_t n) {
+			assert(n > 0);
+			return uint32_t((uint64_t(next()) * n) >> 32);
+		}
+
+		///
+		/// \brief uniform
+		/// \return Random float in range [0, 1) with 24 random bits.
+		///
+		float uniform() {
+			return float(next() >> 8) * (1.0f / 16777216.0f);
+		}
+
+		///
+		/// \brief uniform
+		/// \return Random float in range [minValue, maxValue).
+		///
+		float uniform(float minValue, float maxValue) {
+			return minValue + (maxValue - minValue) * uniform();
+		}
+
+		uint64_t getState() const {
+			return m_state;
+		}
+
+	private:
+		static constexpr uint64_t INCREMENT = 1442695040888963407ull;
+		uint64_t m_state;
+	};
+} // End - namespace rng
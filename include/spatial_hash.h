@@ -0,0 +1,199 @@
+#pragma once
+#include <assert.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+namespace spatial_hash {
+
+///
+/// \brief The Entry class. Circle shaped object in the grid.
+///
+struct Entry {
+	int			type = 0;	// User defined entity type (car, item, projectile...)
+	uint32_t	id = 0;		// Entity index inside its type.
+	float		x = 0;
+	float		y = 0;
+	float		r = 0;
+};
+
+///
+/// \brief The Grid class
+///
+/// Uniform grid of cells of cellSize (1 = one tile), hashed to a fixed number of buckets.
+/// Entries are inserted to each cell covered by their bounding box. The grid is rebuilt each
+/// tick: insert all entries and call build(), which sorts entries to buckets with counting sort.
+///
+class Grid {
+public:
+	Grid()
+		: Grid(1.0f, 4096) {
+	}
+
+	Grid(float cellSize, size_t numBuckets)
+		: m_cellSize(cellSize)
+		, m_invCellSize(1.0f/cellSize) {
+		// Number of buckets must be power of two:
+		size_t n = 1;
+		while(n < numBuckets) n <<= 1;
+		m_bucketStart.resize(n+1, 0);
+	}
+
+	///
+	/// \brief clear Removes all entries.
+	///
+	void clear() {
+		m_entries.clear();
+		m_slots.clear();
+		std::fill(m_bucketStart.begin(), m_bucketStart.end(), 0);
+	}
+
+	///
+	/// \brief insert Adds entry to be sorted by next build.
+	///
+	void insert(int type, uint32_t id, float x, float y, float r) {
+		m_entries.push_back(Entry{type, id, x, y, r});
+	}
+
+	///
+	/// \brief build Sorts inserted entries to buckets.
+	///
+	void build() {
+		const auto numBuckets = m_bucketStart.size()-1;
+		std::fill(m_bucketStart.begin(), m_bucketStart.end(), 0);
+		// Count entries per bucket:
+		size_t numSlots = 0;
+		for(const auto& e : m_entries) {
+			forCells(e.x-e.r, e.y-e.r, e.x+e.r, e.y+e.r, [&](int cx, int cy) {
+				++m_bucketStart[getBucket(cx, cy)+1];
+				++numSlots;
+			});
+		}
+		// Prefix sum:
+		for(size_t i=0; i<numBuckets; ++i) {
+			m_bucketStart[i+1] += m_bucketStart[i];
+		}
+		// Fill slots:
+		m_slots.resize(numSlots);
+		m_fill.assign(m_bucketStart.begin(), m_bucketStart.end()-1);
+		for(uint32_t entryIndex=0; entryIndex<m_entries.size(); ++entryIndex) {
+			const auto& e = m_entries[entryIndex];
+			forCells(e.x-e.r, e.y-e.r, e.x+e.r, e.y+e.r, [&](int cx, int cy) {
+				m_slots[m_fill[getBucket(cx, cy)]++] = Slot{entryIndex, cx, cy};
+			});
+		}
+	}
+
+	///
+	/// \brief queryRadius Calls f(const Entry&) once for each entry, which overlaps circle at x,y with radius r.
+	///
+	template<typename Func>
+	void queryRadius(float x, float y, float r, Func f) const {
+		forCells(x-r, y-r, x+r, y+r, [&](int cx, int cy) {
+			forSlots(cx, cy, [&](const Entry& e) {
+				// Report only in the cell containing min corner of overlapping bounds, so each entry is reported once.
+				if(getCell(std::max(x-r, e.x-e.r)) != cx || getCell(std::max(y-r, e.y-e.r)) != cy) {
+					return;
+				}
+				const auto dx = e.x-x;
+				const auto dy = e.y-y;
+				const auto rr = e.r+r;
+				if(dx*dx + dy*dy <= rr*rr) {
+					f(e);
+				}
+			});
+		});
+	}
+
+	///
+	/// \brief findPairs Calls f(const Entry&, const Entry&) once for each candidate pair with overlapping bounds.
+	/// \param canCollide = f(int typeA, int typeB) -> bool. Pairs of types not colliding are skipped.
+	/// \param f
+	///
+	template<typename CanCollideFunc, typename Func>
+	void findPairs(CanCollideFunc canCollide, Func f) const {
+		const auto numBuckets = m_bucketStart.size()-1;
+		for(size_t bucket=0; bucket<numBuckets; ++bucket) {
+			const auto begin = m_bucketStart[bucket];
+			const auto end = m_bucketStart[bucket+1];
+			for(auto i=begin; i<end; ++i) {
+				const auto& si = m_slots[i];
+				const auto& a = m_entries[si.entry];
+				for(auto j=i+1; j<end; ++j) {
+					const auto& sj = m_slots[j];
+					if(sj.cx != si.cx || sj.cy != si.cy) {
+						continue; // Hash collision of different cells
+					}
+					const auto& b = m_entries[sj.entry];
+					if(false == canCollide(a.type, b.type)) {
+						continue;
+					}
+					if(std::abs(a.x-b.x) > a.r+b.r || std::abs(a.y-b.y) > a.r+b.r) {
+						continue;
+					}
+					// Report only in the cell containing min corner of overlapping bounds:
+					if(getCell(std::max(a.x-a.r, b.x-b.r)) != si.cx || getCell(std::max(a.y-a.r, b.y-b.r)) != si.cy) {
+						continue;
+					}
+					f(a, b);
+				}
+			}
+		}
+	}
+
+	const std::vector<Entry>& getEntries() const {
+		return m_entries;
+	}
+
+	float getCellSize() const {
+		return m_cellSize;
+	}
+
+private:
+	struct Slot {
+		uint32_t	entry;
+		int			cx;
+		int			cy;
+	};
+
+	int getCell(float v) const {
+		return int(std::floor(v*m_invCellSize));
+	}
+
+	size_t getBucket(int cx, int cy) const {
+		const uint32_t h = (uint32_t(cx) * 73856093u) ^ (uint32_t(cy) * 19349663u);
+		return h & (m_bucketStart.size()-2);
+	}
+
+	template<typename Func>
+	void forCells(float x0, float y0, float x1, float y1, Func f) const {
+		const int cx0 = getCell(x0), cy0 = getCell(y0);
+		const int cx1 = getCell(x1), cy1 = getCell(y1);
+		for(int cy=cy0; cy<=cy1; ++cy) {
+			for(int cx=cx0; cx<=cx1; ++cx) {
+				f(cx, cy);
+			}
+		}
+	}
+
+	template<typename Func>
+	void forSlots(int cx, int cy, Func f) const {
+		const auto bucket = getBucket(cx, cy);
+		for(auto i=m_bucketStart[bucket]; i<m_bucketStart[bucket+1]; ++i) {
+			const auto& s = m_slots[i];
+			if(s.cx == cx && s.cy == cy) {
+				f(m_entries[s.entry]);
+			}
+		}
+	}
+
+	float					m_cellSize;
+	float					m_invCellSize;
+	std::vector<Entry>		m_entries;
+	std::vector<Slot>		m_slots;
+	std::vector<size_t>		m_bucketStart;
+	std::vector<size_t>		m_fill;
+};
+
+} // End - namespace spatial_hash
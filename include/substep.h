@@ -0,0 +1,74 @@
+#pragma once
+#include <assert.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+///
+/// SUBSTEP: Sub-step scheduler of colliding bodies.
+/// - substep::Request
+/// - substep::Plan
+/// - substep::schedule(requests, plans, minStepLength, maxSteps, budget) -> size_t
+///
+namespace substep {
+	///
+	/// \brief The Request class. Motion of a body during the tick.
+	///
+	struct Request {
+		float travel = 0.0f;	// Longest distance any point of the body moves during the tick.
+		float clearance = 0.0f;	// Free distance around the body shape.
+	};
+
+	///
+	/// \brief The Plan class. How a body shall be integrated during the tick.
+	///
+	struct Plan {
+		uint16_t	steps = 1;			// Number of sub-steps.
+		float		clearance = 0.0f;	// Body can move this far without collision checks.
+	};
+
+	///
+	/// \brief schedule Chooses number of sub-steps for each body.
+	/// Bodies which can't reach geometry during the tick take one step. Others take steps of length
+	/// of their clearance, but not shorter than minStepLength. If total number of steps exceeds the
+	/// budget, extra steps are shared in proportion to the number of wanted extra steps.
+	/// \param requests		= Container of Request.
+	/// \param plans		= Container of Plan. Resized to the number of requests.
+	/// \param minStepLength	= Shortest distance travelled in one sub-step.
+	/// \param maxSteps		= Maximum number of sub-steps of a body.
+	/// \param budget		= Maximum number of sub-steps of all bodies in the tick. Each body gets at least one.
+	/// \return Total number of scheduled sub-steps.
+	///
+	template<typename Requests, typename Plans>
+	size_t schedule(const Requests& requests, Plans& plans, float minStepLength, size_t maxSteps, size_t budget) {
+		assert(minStepLength > 0.0f && maxSteps > 0);
+		plans.resize(requests.size());
+		size_t numExtra = 0;
+		for(size_t i=0; i<requests.size(); ++i) {
+			const auto& r = requests[i];
+			auto& p = plans[i];
+			p.clearance = r.clearance;
+			p.steps = 1;
+			if(r.travel > r.clearance) {
+				const auto stepLength = std::max(r.clearance, minStepLength);
+				const auto steps = size_t(std::ceil(r.travel / stepLength));
+				p.steps = uint16_t(std::clamp<size_t>(steps, 1, maxSteps));
+			}
+			numExtra += p.steps - 1;
+		}
+		const size_t numBodies = requests.size();
+		const size_t extraBudget = budget > numBodies ? budget - numBodies : 0;
+		if(numExtra <= extraBudget) {
+			return numBodies + numExtra;
+		}
+		// Over budget: scale extra steps down.
+		size_t total = 0;
+		for(auto& p : plans) {
+			const size_t extra = (size_t(p.steps - 1) * extraBudget) / numExtra;
+			p.steps = uint16_t(1 + extra);
+			total += p.steps;
+		}
+		return total;
+	}
+} // End - namespace substep
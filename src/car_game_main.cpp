@@ -5,6 +5,8 @@
 namespace view = hungerland_view;
 /// MODEL: Sovelluksen datan tietorakenteet:
 #include <car_game/std_model.h>
+/// Loputon proseduraalisesti generoitu rata:
+#include <car_game/endless.h>
 #include <time.h>
 
 // Määritä nimiavatuudet demo pelin nimiavaruuksiksi:
@@ -22,26 +24,30 @@ namespace model = car_model;
 int selection = -1;
 int aiDifficulty = -1;
 typedef model::GameState < hungerland::texture::Texture, glm::vec2, hungerland::map::Map > Game;
+static const size_t PROJECTILE_CAPACITY = 4096; // Maximum number of vegetables alive at the same time
+static const char* ENDLESS_MAP = "assets/endless.tmx"; // Empty map with layers of car_endless::Track
+std::shared_ptr<car_endless::Track> endlessTrack; // Loputon rata, jos valittu
 auto DemoApplication(hungerland::window::Window& window, std::vector<Game::PolicyFunc> policies, std::vector<Game::EventFunc> eventHandlers) {
 	srand((unsigned)time(0));
 	typedef std::shared_ptr<hungerland::texture::Texture> TexturePtr;
 	std::map<std::string, TexturePtr> textureCache;
-	auto loadTexture = [&textureCache](const std::string& filename, bool black=false) -> TexturePtr{
-		auto hash = filename + (black ? "_black" : "");
-		auto it = textureCache.find(hash);
-		if (it != textureCache.end()) {
-			return it->second;
-		}
-
-		hungerland::window::Image image(filename);
-		assert(image.data != 0);
-		std::vector<uint8_t> imageData;
-		imageData.resize(image.size.y * image.size.x * 4);
+	// Kuvan purku ja läpinäkyvät pikselit. Säieturvallinen, joten kartan kuvat puretaan rinnakkain:
+	auto decodeImage = [](const std::string& filename, bool black) {
+		auto image = hungerland::map::decodeImage(filename);
+		assert(image != 0);
+		auto decoded = std::make_shared<hungerland::map::DecodedImage>();
+		decoded->width = image->width;
+		decoded->height = image->height;
+		decoded->channels = 4;
+		std::vector<uint8_t>& imageData = decoded->pixels;
+		imageData.resize(image->height * image->width * 4);
+		const auto bpp = image->channels;
+		const auto* data = image->pixels.data();
 		bool hasTransparent = false;
-		for (auto y = 0; y < image.size.y; ++y) {
-			for (auto x = 0; x < image.size.x; ++x) {
-				auto id = 4 * unsigned(y * image.size.x + x);
-				auto is = image.bpp * unsigned(y * image.size.x + x);
+		for (auto y = 0u; y < image->height; ++y) {
+			for (auto x = 0u; x < image->width; ++x) {
+				auto id = 4 * unsigned(y * image->width + x);
+				auto is = bpp * unsigned(y * image->width + x);
 				if (black) {
 					imageData[id + 0] = 0;
 					imageData[id + 1] = 0;
@@ -49,23 +55,38 @@ auto DemoApplication(hungerland::window::Window& window, std::vector<Game::Polic
 					imageData[id + 3] = 80;
 				}
 				else {
-					imageData[id + 0] = image.data[is + 0];
-					imageData[id + 1] = image.data[is + 1];
-					imageData[id + 2] = image.data[is + 2];
+					imageData[id + 0] = data[is + 0];
+					imageData[id + 1] = data[is + 1];
+					imageData[id + 2] = data[is + 2];
 					imageData[id + 3] = 0xff;
 				}
-				if (image.data[is + 0] > 0xf0 && image.data[is + 1] <= 0x0f && image.data[is + 2] > 0xf0) {
+				if (data[is + 0] > 0xf0 && data[is + 1] <= 0x0f && data[is + 2] > 0xf0) {
 					hasTransparent = true;
 					imageData[id + 3] = 0x00;
 				}
 			}
 		}
 		printf("Loaded image: %s %s transparent pixels\n", filename.c_str(), hasTransparent ? "has" : "has not");
-		//auto texture = std::make_shared<hungerland::texture::Texture>(width, height, 4, &data[0]);
-		TexturePtr texture = std::make_shared<hungerland::texture::Texture>(image.size.x, image.size.y, 4, &imageData[0]);
+		return decoded;
+	};
+	// Tekstuurin luonti GL-säikeessä:
+	auto createTexture = [&textureCache](const std::string& filename, const hungerland::map::DecodedImage& image, bool black) -> TexturePtr {
+		auto hash = filename + (black ? "_black" : "");
+		auto it = textureCache.find(hash);
+		if (it != textureCache.end()) {
+			return it->second;
+		}
+		TexturePtr texture = std::make_shared<hungerland::texture::Texture>(image.width, image.height, 4, &image.pixels[0]);
 		textureCache[hash] = texture;
 		return texture;
 	};
+	auto loadTexture = [&textureCache, decodeImage, createTexture](const std::string& filename, bool black=false) -> TexturePtr{
+		auto it = textureCache.find(filename + (black ? "_black" : ""));
+		if (it != textureCache.end()) {
+			return it->second;
+		}
+		return createTexture(filename, *decodeImage(filename, black), black);
+	};
 
 
 	/// Lisää player inputin lisäksi AI:n käyttäytymisiä:
@@ -95,10 +116,21 @@ auto DemoApplication(hungerland::window::Window& window, std::vector<Game::Polic
 
 
 	// Create map:
-	auto tileMap = hungerland::map::load<hungerland::map::Map>(loadTexture, "assets/race2.tmx", false);
+	auto tileMap = hungerland::map::load<hungerland::map::Map>([decodeImage](const std::string& filename) {
+		return decodeImage(filename, false);
+	}, [createTexture](const std::string& filename, const hungerland::map::DecodedImage& image) {
+		return createTexture(filename, image, false);
+	}, hungerland::map::findCooked(selection == 3 ? ENDLESS_MAP : "assets/race2.tmx"), false);
+	// Loputon rata generoidaan tyhjään karttaan pelin siemenestä:
+	const uint64_t seed = uint64_t(rand());
+	endlessTrack = selection == 3 ? std::make_shared<car_endless::Track>(tileMap, seed) : nullptr;
 
-	// Varsinaiset pelaajainstanssit (agentit):
-	Game::VecType posC(7.5f, 9.0f);
+	// Varsinaiset pelaajainstanssit (agentit). Lähtöpaikka kartan "start"-objektista:
+	const auto* start = tileMap->getObjects().find("start");
+	Game::VecType posC = start ? Game::VecType(start->getCenter()) : Game::VecType(7.5f, 9.0f);
+	if (endlessTrack) {
+		posC = Game::VecType(endlessTrack->getStart());
+	}
 	Game::VecType posT = posC - Game::VecType(1.0, 0);
 	std::vector<Game::PrefabAgent> agents;
 	auto aiType = rand() % 2;
@@ -108,7 +140,7 @@ auto DemoApplication(hungerland::window::Window& window, std::vector<Game::Polic
 		{aiType==0?classes[SEDAN]: classes[VAGON],	{{posC + Game::VecType(0.0f, 1)}, {classes[TRAILER].visualId, posT + Game::VecType(0.0f, 1)}}}, // AI
 		};
 	}
-	else if (selection == 2) {
+	else if (selection == 2 || selection == 3) {
 		agents = {
 		{classes[PLAYER],	{{posC}, {classes[TRAILER].visualId, posT}}}, // Pelaaja
 		{aiType == 0 ? classes[SEDAN] : classes[VAGON],	{{posC + Game::VecType(0.0f, 1)}, {classes[TRAILER].visualId, posT + Game::VecType(0.0f, 1)}}}, // AI
@@ -141,10 +173,19 @@ auto DemoApplication(hungerland::window::Window& window, std::vector<Game::Polic
 		// TODO: Lisää/poista itemeitä.
 	};
 
-	// Projectiles:
-	std::vector<Game::Goal> goals = {
-		{Game::VecType(tileMap->getMapSize().x - 30, tileMap->getMapSize().y - 10)},
-	};
+	// Maalit kartan "goal"-objekteista:
+	std::vector<Game::Goal> goals;
+	for(const auto& object : tileMap->getObjects()) {
+		if(object.type == "goal") {
+			goals.push_back({Game::VecType(object.getCenter())});
+		}
+	}
+	if(endlessTrack) {
+		goals = {{Game::VecType(endlessTrack->getGoal(endlessTrack->getStart()))}};
+	}
+	if(goals.empty()) {
+		goals.push_back({Game::VecType(tileMap->getMapSize().x - 30, tileMap->getMapSize().y - 10)});
+	}
 
 
 	std::vector<Game::TexturePtr> textures = {
@@ -172,14 +213,19 @@ auto DemoApplication(hungerland::window::Window& window, std::vector<Game::Polic
 	};
 	printf("INFO: Ai Difficulty:%d\n", aiDifficulty);
 	// Palauta uusi pelin alkutila:
-	return Game {
+	Game game {
 		aiDifficulty,
 		model::genClasses(classes), textures, texturesBlack, tileMap,
 		model::genEntities<Game::EntityAgent>(agents),
 		model::genEntities<Game::EntityItem>(items),
-		model::genEntities<Game::EntityProjectile>(projectiles),
+		model::genProjectiles<Game::ProjectilePool>(PROJECTILE_CAPACITY, projectiles),
 		goals,
 	};
+	// Each game is different, but can be replayed with the printed seed:
+	printf("INFO: Seed:%llu\n", (unsigned long long)seed);
+	env::seed(game, seed);
+	env::resolveLayers(game);
+	return game;
 };
 
 ///
@@ -187,17 +233,26 @@ auto DemoApplication(hungerland::window::Window& window, std::vector<Game::Polic
 /// \return int
 ///
 int main() {
-	static const auto updateFunc = env::update<Game,Game::AgentId,Game::Action,Game::Events,Game::VecType,float>;
+	static const auto envUpdateFunc = env::update<Game,Game::AgentId,Game::Action,Game::Events,Game::VecType,float>;
+	// Loputon rata vierittää karttaa pelin päivityksen jälkeen:
+	static const auto updateFunc = [](Game& game, float dt) -> const Game& {
+		envUpdateFunc(game, dt);
+		if (endlessTrack) {
+			endlessTrack->update(game);
+		}
+		return game;
+	};
 	static const auto isEndFunc = game::isGameOver<Game>;
 	
-	while (selection != 1 && selection != 2) {
+	while (selection < 1 || selection > 3) {
 		printf("\nGlobal Game Jam 2023 Game Menu:\n");
 		printf("1. Run demo\n");
-		printf("2. Run single player\n-> ");
+		printf("2. Run single player\n");
+		printf("3. Run single player on endless track\n-> ");
 		char buf[255] = "";
 		scanf("%s", &buf[0]);
 		selection = atoi(buf);
-		if (selection != 1 && selection != 2) {
+		if (selection < 1 || selection > 3) {
 			printf("\nInvalid selection: %d!\n", selection);
 		}
 	}
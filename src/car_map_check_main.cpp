@@ -0,0 +1,141 @@
+/// Consistency check of incrementally updated collision data of tile layers.
+/// Streams generated chunks of the endless track to a map, scrolls it and edits single tiles like the game
+/// does at runtime, and compares distance fields and collision rectangles of the map after each change
+/// against a full bake of the same tiles, see clearance::Field and rects::RectSet.
+///
+/// Usage: GGJ2023CarMapCheck [--map file.tmx|file.hlmap] [--scrolls N] [--edits N] [--seed N]
+///
+/// Distance fields are exact after scrolls and setTiles. After setTile, distances of tiles which got further from
+/// the surface may stay lower, see clearance::Field::setSolid, so only their sign and upper bound are checked.
+/// Collision rectangles must always cover each solid tile exactly once and no free tiles.
+/// Exits with 1 if any tile does not match.
+///
+/// ENDLESS: Loputon generoitu rata:
+#include <car_game/endless.h>
+#include <hungerland/clearance.h>
+#include <hungerland/rects.h>
+#include <rng.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+struct Config {
+	std::string mapFile = "assets/endless.tmx";	// Map with layers of car_endless::Track
+	size_t numScrolls = 8;
+	size_t numEdits = 50;		// Tiles changed by setTile after each scroll of the second half of scrolls
+	uint64_t seed = 0;
+};
+
+///
+/// \brief checkClearance Compares distance field of the layer against a full bake.
+/// \param isExact	= Distances must be equal. Otherwise distances may be nearer to the surface than baked ones.
+/// \return Number of tiles with wrong distance.
+///
+size_t checkClearance(const hungerland::map::Map& map, size_t layerId, bool isExact) {
+	const auto baked = hungerland::clearance::Field::bake(map, layerId);
+	const auto& field = map.getClearance(layerId);
+	const auto& size = field.getSize();
+	size_t numBad = 0;
+	for(size_t i = 0; i < size.x*size.y; ++i) {
+		const int d = field.getData()[i];
+		const int b = baked.getData()[i];
+		const bool isBad = isExact ? d != b : ((d < 0) != (b < 0) || std::abs(d) > std::abs(b));
+		numBad += isBad ? 1 : 0;
+	}
+	return numBad;
+}
+
+///
+/// \brief checkRects Checks that collision rectangles of the layer cover each solid tile exactly once.
+/// \return Number of tiles covered wrong.
+///
+size_t checkRects(const hungerland::map::Map& map, size_t layerId) {
+	const auto& rects = map.getCollisionRects(layerId);
+	const auto& size = map.getMapSize();
+	size_t numBad = 0;
+	for(int y = 0; y < int(size.y); ++y) {
+		for(int x = 0; x < int(size.x); ++x) {
+			size_t numCovering = 0;
+			rects.forEachOverlapping(x, y, x, y, [&](const hungerland::rects::Rect& r) {
+				const bool isInside = r.x <= x && x < r.x + r.width && r.y <= y && y < r.y + r.height;
+				numCovering += isInside ? 1 : 0;
+				numBad += isInside ? 0 : 1;
+			});
+			const size_t numExpected = map.getTileId(layerId, size_t(x), size_t(y)) > 0 ? 1 : 0;
+			numBad += numCovering != numExpected ? 1 : 0;
+		}
+	}
+	return numBad;
+}
+
+int main(int argc, char* argv[]) {
+	Config cfg;
+	for(int i = 1; i + 1 < argc; i += 2) {
+		const std::string key = argv[i];
+		const std::string value = argv[i + 1];
+		if(key == "--map") cfg.mapFile = value;
+		else if(key == "--scrolls") cfg.numScrolls = std::stoul(value);
+		else if(key == "--edits") cfg.numEdits = std::stoul(value);
+		else if(key == "--seed") cfg.seed = std::stoull(value);
+		else {
+			printf("Unknown argument: %s\n", key.c_str());
+			return 1;
+		}
+	}
+	namespace endless = car_endless;
+	auto map = hungerland::map::loadHeadless<hungerland::map::Map>(hungerland::map::findCooked(cfg.mapFile));
+	const int width = int(map->getMapSize().x);
+	const int height = int(map->getMapSize().y);
+	const size_t layerIds[endless::NUM_LAYERS] = {
+		map->getLayerIndex("RoadBG"), map->getLayerIndex("RoadTiles"), map->getLayerIndex("CollisionLayer"),
+	};
+	const hungerland::procgen::WangTiles wangTiles(endless::SIDE, 2, endless::NUM_STYLES, endless::paintTile);
+	rng::Random random(cfg.seed);
+
+	size_t numBad = 0;
+	bool isExact = true;
+	auto check = [&](const char* change, size_t index) {
+		for(const auto layerId : layerIds) {
+			const size_t numBadDistances = checkClearance(*map, layerId, isExact);
+			const size_t numBadRects = checkRects(*map, layerId);
+			if(numBadDistances > 0 || numBadRects > 0) {
+				printf("%s %zu, layer %zu: %zu wrong distances, %zu tiles covered wrong\n",
+					change, index, layerId, numBadDistances, numBadRects);
+			}
+			numBad += numBadDistances + numBadRects;
+		}
+	};
+	auto writeChunk = [&](int64_t chunk, int x) {
+		const auto tiles = endless::generateChunk(wangTiles, cfg.seed, chunk, height);
+		for(size_t i = 0; i < endless::NUM_LAYERS; ++i) {
+			map->setTiles(layerIds[i], size_t(x), 0, tiles[i]);
+		}
+	};
+
+	const int numChunks = width / endless::CHUNK_WIDTH;
+	for(int chunk = 0; chunk < numChunks; ++chunk) {
+		writeChunk(chunk, chunk*endless::CHUNK_WIDTH);
+	}
+	check("Write", 0);
+	for(size_t scroll = 1; scroll <= cfg.numScrolls; ++scroll) {
+		map->scrollTiles(endless::CHUNK_WIDTH);
+		writeChunk(int64_t(numChunks + scroll - 1), width - endless::CHUNK_WIDTH);
+		check("Scroll", scroll);
+		if(2*scroll <= cfg.numScrolls) {
+			continue;
+		}
+		// Buildings and roads placed and removed at runtime:
+		for(size_t i = 0; i < cfg.numEdits; ++i) {
+			const auto layer = random.below(2) == 0 ? endless::ROADS : endless::COLLISION;
+			const auto x = random.below(uint32_t(width));
+			const auto y = random.below(uint32_t(height));
+			const int tileId = random.below(2) == 0 ? 0 : (layer == endless::ROADS ? endless::CROSSING_TILE : endless::BUILDING_TILE);
+			map->setTile(layerIds[layer], x, y, tileId);
+		}
+		isExact = false;
+		check("Edit", scroll);
+	}
+	printf("Map: %s, scrolls: %zu, edits: %zu, seed: %llu\n", cfg.mapFile.c_str(), cfg.numScrolls, cfg.numEdits, (unsigned long long)cfg.seed);
+	printf("%s: %zu wrong tiles\n", numBad == 0 ? "OK" : "FAILED", numBad);
+	return numBad == 0 ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+/// Headless car race simulation runner and physics benchmark.
+/// Runs car_env::update without window, GL context or textures as fast as possible
+/// and reports simulated steps per second, update phase timings and final state hash.
+///
+/// Usage: GGJ2023CarRaceHeadless [--map file.tmx|file.hlmap] [--agents N] [--projectiles N] [--items N] [--refill 0|1] [--steps N] [--dt seconds] [--policy ai|scripted|sensor] [--seed N] [--endless 0|1] [--scroll N]
+///
+/// With --endless 1 the race runs on an endless track generated from the seed, on map ENDLESS_MAP unless --map is given.
+/// With --scroll N the endless track scrolls also every N steps regardless of the cars, so that scrolling and its
+/// determinism can be checked with any policy by comparing state hashes of runs.
+///
+/// CONTROLLER: Pelin funktiot ja agenttifunktiot:
+#include <car_game/controller.h>
+/// MODEL: Sovelluksen datan tietorakenteet:
+#include <car_game/std_model.h>
+/// ENDLESS: Loputon generoitu rata:
+#include <car_game/endless.h>
+#include <hungerland/texture.h>
+#include <chrono>
+#include <cstring>
+
+namespace env = car_env;
+namespace game = car_game;
+namespace model = car_model;
+
+typedef model::GameState < hungerland::texture::Texture, glm::vec2, hungerland::map::Map > Game;
+static const size_t PROJECTILE_CAPACITY = 4096; // Maximum number of vegetables alive at the same time
+static const char* ENDLESS_MAP = "assets/endless.tmx"; // Empty map with layers of car_endless::Track
+
+/// Entiteettien nimet (samat kuin demossa):
+enum Classes {
+	PLAYERAI, TRAILER, LANTHU, PORCHANA, REDJUUR, ZIBAL, NUM_CLASSES
+};
+
+struct Config {
+	std::string mapFile = hungerland::map::findCooked("assets/race2.tmx");
+	size_t numAgents = 2;
+	size_t numProjectiles = 8;	// Per agent
+	size_t numItems = 0;		// Scattered along the start of the track
+	bool refill = true;			// Refill trailers with new cargo when vegetables fall off
+	size_t numSteps = 10000;
+	float dt = 1.0f/60.0f;
+	std::string policy = "ai";
+	uint64_t seed = 0;			// Same seed and arguments give the same state hash
+	bool endless = false;		// Endless track generated from the seed
+	size_t scrollSteps = 0;		// Steps between forced scrolls of the endless track, 0 for none
+};
+
+///
+/// \brief scriptedDriver Full gas and steer towards the goal.
+///
+template<typename Action, typename AgentId, typename GameState>
+Action scriptedDriver(AgentId agentId, const GameState& gameState) {
+	if(false == gameState.isRunning) {
+		return Action{0, 0};
+	}
+	const auto& car = gameState.agents[agentId].state.car;
+	const auto d = gameState.goals[0].state - car.position;
+	const auto forward = car_env::getRotationMat(car) * glm::vec4(1, 0, 0, 1);
+	const float cr = forward.x * d.y - forward.y * d.x;
+	int steer = std::abs(cr) < 0.5f ? 0 : 1;
+	return Action{1, cr < 0 ? -steer : +steer};
+}
+
+///
+/// \brief refillCargo Spawns new cargo for each agent, which has less than numCargo projectiles on its trailer.
+/// \return Number of spawned projectiles.
+///
+size_t refillCargo(Game& game, size_t numCargo) {
+	static std::vector<size_t> cargo;
+	cargo.assign(game.agents.size(), 0);
+	const auto& p = game.projectiles;
+	for(const auto slot : p.getAlive()) {
+		if(p.state[slot] == env::START || p.state[slot] == env::TRAILER) {
+			++cargo[p.owner[slot]];
+		}
+	}
+	size_t numSpawned = 0;
+	for(size_t owner = 0; owner < cargo.size(); ++owner) {
+		for(auto i = cargo[owner]; i < numCargo; ++i) {
+			if(env::spawnCargo(game, int(owner), Game::VisualType(LANTHU + (i % 4))) == pool::Slots::INVALID) {
+				return numSpawned; // Pool is full
+			}
+			++numSpawned;
+		}
+	}
+	return numSpawned;
+}
+
+///
+/// \brief createGame Creates game state with collision data of the map only.
+/// \param track	= Set to the endless track streamed to the map, if cfg.endless is set.
+///
+Game createGame(const Config& cfg, std::shared_ptr<car_endless::Track>& track) {
+	Game::PolicyFunc policy = car_ai::plannerDriver<Game::Action,Game::Event,Game::AgentId,Game>;
+	if(cfg.policy == "scripted") {
+		policy = scriptedDriver<Game::Action,Game::AgentId,Game>;
+	} else if(cfg.policy == "sensor") {
+		policy = car_ai::sensorDriver<Game::Action,Game::Event,Game::AgentId,Game>;
+	}
+
+	typedef Game::MetaClass Class;
+	std::array<Class, NUM_CLASSES> classes = {
+		Class{PLAYERAI,		policy, 0},
+		Class{TRAILER,		0, 0},
+		Class{LANTHU,		0, 0},
+		Class{PORCHANA,		0, 0},
+		Class{REDJUUR,		0, 0},
+		Class{ZIBAL,		0, 0},
+	};
+
+	auto tileMap = hungerland::map::loadHeadless<hungerland::map::Map>(cfg.mapFile);
+	if(cfg.endless) {
+		track = std::make_shared<car_endless::Track>(tileMap, cfg.seed);
+	}
+
+	const auto* start = tileMap->getObjects().find("start");
+	Game::VecType posC = start ? Game::VecType(start->getCenter()) : Game::VecType(7.5f, 9.0f);
+	if(track) {
+		posC = Game::VecType(track->getStart());
+	}
+	Game::VecType posT = posC - Game::VecType(1.0, 0);
+	std::vector<Game::PrefabAgent> agents;
+	std::vector<Game::PrefabProjectile> projectiles;
+	for(size_t i = 0; i < cfg.numAgents; ++i) {
+		const auto offset = Game::VecType(0.0f, float(i % 2));
+		agents.push_back({classes[PLAYERAI], {{posC + offset}, {classes[TRAILER].visualId, posT + offset}}});
+		for(size_t j = 0; j < cfg.numProjectiles; ++j) {
+			projectiles.push_back({classes[LANTHU + (j % 4)], {int(i)}});
+		}
+	}
+
+	std::vector<Game::PrefabItem> items;
+	for(size_t i = 0; i < cfg.numItems; ++i) {
+		const auto pos = posC + Game::VecType(2.0f + 0.5f*float(i % 200), 0.5f*float((i / 200) % 4) - 1.0f);
+		items.push_back({classes[LANTHU + (i % 4)], {pos}});
+	}
+
+	std::vector<Game::Goal> goals;
+	for(const auto& object : tileMap->getObjects()) {
+		if(object.type == "goal") {
+			goals.push_back({Game::VecType(object.getCenter())});
+		}
+	}
+	if(track) {
+		goals = {{Game::VecType(track->getGoal(track->getStart()))}};
+	} else if(goals.empty()) {
+		goals.push_back({Game::VecType(tileMap->getMapSize().x - 30, tileMap->getMapSize().y - 10)});
+	}
+
+	Game game {
+		5,
+		model::genClasses(classes), {}, {}, tileMap,
+		model::genEntities<Game::EntityAgent>(agents),
+		model::genEntities<Game::EntityItem>(items),
+		model::genProjectiles<Game::ProjectilePool>(PROJECTILE_CAPACITY, projectiles),
+		goals,
+	};
+	env::resolveLayers(game);
+	return game;
+}
+
+int main(int argc, char* argv[]) {
+	Config cfg;
+	bool hasMap = false;
+	for(int i = 1; i + 1 < argc; i += 2) {
+		const std::string key = argv[i];
+		const std::string value = argv[i + 1];
+		if(key == "--map") { cfg.mapFile = value; hasMap = true; }
+		else if(key == "--agents") cfg.numAgents = std::stoul(value);
+		else if(key == "--projectiles") cfg.numProjectiles = std::stoul(value);
+		else if(key == "--items") cfg.numItems = std::stoul(value);
+		else if(key == "--refill") cfg.refill = std::stoul(value) != 0;
+		else if(key == "--steps") cfg.numSteps = std::stoul(value);
+		else if(key == "--dt") cfg.dt = std::stof(value);
+		else if(key == "--policy") cfg.policy = value;
+		else if(key == "--seed") cfg.seed = std::stoull(value);
+		else if(key == "--endless") cfg.endless = std::stoul(value) != 0;
+		else if(key == "--scroll") cfg.scrollSteps = std::stoul(value);
+		else {
+			printf("Unknown argument: %s\n", key.c_str());
+			return 1;
+		}
+	}
+	if(cfg.endless && false == hasMap) {
+		cfg.mapFile = ENDLESS_MAP;
+	}
+	static const auto updateFunc = env::update<Game,Game::AgentId,Game::Action,Game::Events,Game::VecType,float>;
+	std::shared_ptr<car_endless::Track> track;
+	auto gameState = createGame(cfg, track);
+	env::seed(gameState, cfg.seed);
+
+	typedef std::chrono::steady_clock Clock;
+	const auto start = Clock::now();
+	size_t steps = 0;
+	size_t numSpawned = 0;
+	while(steps < cfg.numSteps) {
+		updateFunc(gameState, cfg.dt);
+		if(track) {
+			track->update(gameState, cfg.scrollSteps > 0 && (steps + 1) % cfg.scrollSteps == 0);
+		}
+		if(cfg.refill) {
+			numSpawned += refillCargo(gameState, cfg.numProjectiles);
+		}
+		++steps;
+		if(game::isGameOver(gameState)) {
+			break;
+		}
+	}
+	const double totalTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+	const auto& t = gameState.timings;
+	auto ms = [steps](double seconds) {
+		return 1000.0 * seconds / double(steps);
+	};
+	printf("Map: %s, agents: %zu, projectiles: %zu, items: %zu (%zu sleeping), policy: %s, dt: %f\n",
+		cfg.mapFile.c_str(), gameState.agents.size(), gameState.projectiles.size(),
+		gameState.items.size() + gameState.sleepingItems.size(), gameState.sleepingItems.size(), cfg.policy.c_str(), cfg.dt);
+	for(size_t i = 0; i < gameState.agents.size(); ++i) {
+		const auto& pos = gameState.agents[i].state.car.position;
+		printf("Agent %zu position: <%.2f, %.2f>\n", i, pos.x, pos.y);
+	}
+	if(track) {
+		printf("Endless track: %lld chunks scrolled\n", (long long)track->getOrigin());
+	}
+	printf("Projectiles spawned: %zu, alive: %zu\n", numSpawned, gameState.projectiles.size());
+	printf("Simulated steps: %zu (%.2f s game time) in %.3f s\n", steps, gameState.totalTime, totalTime);
+	printf("Steps/sec: %.1f\n", double(steps) / totalTime);
+	printf("Per step: substeps=%.4f ms, sensors=%.4f ms, policy=%.4f ms, cars=%.4f ms, occupancy=%.4f ms\n",
+		ms(t.substeps), ms(t.sensors), ms(t.policy), ms(t.cars), ms(t.occupancy));
+	printf("Per step: items=%.4f ms, projectiles=%.4f ms, tiles=%.4f ms, sleeping=%.4f ms, contacts=%.4f ms\n",
+		ms(t.items), ms(t.projectiles), ms(t.tiles), ms(t.sleeping), ms(t.contacts));
+	printf("Seed: %llu, state hash: %016llx\n", (unsigned long long)cfg.seed, (unsigned long long)game::getStateHash(gameState));
+	return 0;
+}